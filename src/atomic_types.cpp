@@ -1,7 +1,24 @@
+#include "atomic_types.hpp"
+
+#include <array>
 #include <atomic>
+#include <cstddef>
+#include <functional>
+#include <iomanip>
 #include <iostream>
+#include <new>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
 
 #include "formatting.hpp"
+#include "results.hpp"
+#include "timing.hpp"
+#include "types.hpp"
 
 namespace Experiments {
 void testSizesOfAtomicTypes() {
@@ -14,4 +31,135 @@ void testSizesOfAtomicTypes() {
   std::cout << Indentation << "No std::atomic_signed_lock_free or std::atomic_unsigned_lock_free.\n";
 #endif
 }
-} // namespace Experiments
\ No newline at end of file
+
+namespace {
+template <std::size_t Alignment> struct alignas(Alignment) AlignedCounter {
+  std::atomic<U64> value{0};
+};
+
+/**
+ * Counters padded to this size are assumed not to share a cache line.
+ * */
+#ifdef __cpp_lib_hardware_interference_size
+static constexpr std::size_t CounterPadding = std::hardware_destructive_interference_size;
+#else
+static constexpr std::size_t CounterPadding = 64;
+#endif
+
+struct CounterWorkload {
+  std::string_view name;
+  std::function<double(std::size_t threadCount)> measure;
+};
+} // namespace
+
+static constexpr std::size_t IncrementsPerThread = 2'000'000;
+static constexpr std::size_t Repetitions = 3;
+static constexpr int WorkloadNameWidth = 34;
+static constexpr int ThreadColumnWidth = 12;
+static constexpr U32 ThroughputDecimalPlaces = 1;
+
+/**
+ * Returns the median number of millions of increments per second made by all threads together.
+ * */
+template <typename Increment> static double measureIncrements(const std::size_t threadCount, Increment increment) {
+  std::vector<double> durations;
+  for (std::size_t i = 0; i < Repetitions; i++) {
+    durations.push_back(measureConcurrently(threadCount, [&increment](const std::size_t threadIndex) {
+      for (std::size_t j = 0; j < IncrementsPerThread; j++) {
+        increment(threadIndex);
+      }
+    }));
+  }
+  return static_cast<double>(threadCount * IncrementsPerThread) / computeTimingStatistics(std::move(durations)).median / 1e6;
+}
+
+template <std::size_t Alignment> static double measurePerThreadCounters(const std::size_t threadCount) {
+  std::vector<AlignedCounter<Alignment>> counters(threadCount);
+  return measureIncrements(threadCount, [&counters](const std::size_t threadIndex) { counters[threadIndex].value.fetch_add(1, std::memory_order_relaxed); });
+}
+
+static double measureSharedCounter(const std::size_t threadCount, const std::memory_order order) {
+  AlignedCounter<CounterPadding> counter;
+  return measureIncrements(threadCount, [&counter, order](std::size_t) { counter.value.fetch_add(1, order); });
+}
+
+static double measureSharedCounterWithCompareExchange(const std::size_t threadCount) {
+  AlignedCounter<CounterPadding> counter;
+  return measureIncrements(threadCount, [&counter](std::size_t) {
+    auto expected = counter.value.load(std::memory_order_relaxed);
+    while (!counter.value.compare_exchange_weak(expected, expected + 1, std::memory_order_relaxed)) {
+    }
+  });
+}
+
+static void printCounterWorkloads(const std::vector<CounterWorkload> &workloads, const std::vector<std::size_t> &threadCounts) {
+  std::cout << Indentation << std::setw(WorkloadNameWidth) << std::left << "Threads" << std::right;
+  for (const auto threadCount : threadCounts) {
+    std::cout << std::setw(ThreadColumnWidth) << threadCount;
+  }
+  std::cout << "\n";
+  for (const auto &workload : workloads) {
+    std::cout << Indentation << std::setw(WorkloadNameWidth) << std::left << workload.name << std::right;
+    for (const auto threadCount : threadCounts) {
+      const auto millionsOfIncrementsPerSecond = workload.measure(threadCount);
+      std::cout << std::setw(ThreadColumnWidth) << toFixedPrecisionString(millionsOfIncrementsPerSecond, ThroughputDecimalPlaces);
+      const auto metric = std::string(workload.name) + " counter, " + pluralizeAsNeeded(threadCount, "thread");
+      recordResult(metric, millionsOfIncrementsPerSecond, "M increments/s", MetricDirection::HigherIsBetter);
+    }
+    std::cout << "\n";
+  }
+}
+
+/**
+ * Two threads increment counters which are the given number of bytes apart, which is slow while they share a cache line. The cache line size is the
+ * smallest distance from which on the throughput stays close to the throughput of the largest distance.
+ * */
+static void printObservedCacheLineSize() {
+  static constexpr std::array<std::size_t, 7> Distances{8, 16, 32, 64, 128, 256, 512};
+  static constexpr double CloseFraction = 0.8;
+  static constexpr std::size_t ThreadCount = 2;
+  if (std::thread::hardware_concurrency() < ThreadCount) {
+    std::cout << Indentation << "Observing the cache line size needs at least two hardware threads.\n";
+    return;
+  }
+  alignas(4096) static U64 words[ThreadCount * Distances.back() / sizeof(U64)];
+  std::vector<double> throughputs;
+  std::cout << Indentation << "Two threads incrementing counters which are some bytes apart, in millions of increments per second:\n";
+  for (const auto distance : Distances) {
+    throughputs.push_back(measureIncrements(ThreadCount, [distance](const std::size_t threadIndex) {
+      std::atomic_ref<U64>(words[threadIndex * distance / sizeof(U64)]).fetch_add(1, std::memory_order_relaxed);
+    }));
+    std::cout << Indentation << Indentation << std::setw(4) << distance << " bytes: " << toFixedPrecisionString(throughputs.back(), ThroughputDecimalPlaces)
+              << "\n";
+  }
+  auto observedSize = Distances.back();
+  for (auto i = Distances.size(); i > 0 && throughputs[i - 1] >= CloseFraction * throughputs.back(); i--) {
+    observedSize = Distances[i - 1];
+  }
+  std::cout << Indentation << "The observed cache line size is " << pluralizeAsNeeded(observedSize, "byte") << ".\n";
+  recordResult("Observed cache line size", static_cast<double>(observedSize), "bytes", MetricDirection::Exact);
+}
+
+void testAtomicCounterContention() {
+  const auto threadCounts = getScalingThreadCounts();
+  std::cout << "Testing the throughput of atomic increments, in millions of increments per second by all threads together.\n";
+  const auto reportedLineSize = sysconf(_SC_LEVEL1_DCACHE_LINESIZE);
+  std::cout << Indentation << "The system reports a cache line size of ";
+  if (reportedLineSize > 0) {
+    std::cout << pluralizeAsNeeded(static_cast<U64>(reportedLineSize), "byte") << ".\n";
+  } else {
+    std::cout << "an unknown number of bytes.\n";
+  }
+  std::cout << Indentation << "Counters are padded to " << pluralizeAsNeeded(CounterPadding, "byte") << ", the destructive interference size.\n";
+  std::cout << Indentation << "This machine runs " << pluralizeAsNeeded(threadCounts.back(), "hardware thread") << ".\n";
+  std::cout << Indentation << "One counter per thread:\n";
+  printCounterWorkloads({{"packed", measurePerThreadCounters<sizeof(std::atomic<U64>)>}, {"padded", measurePerThreadCounters<CounterPadding>}}, threadCounts);
+  std::cout << Indentation << "One counter shared by all threads:\n";
+  printCounterWorkloads({{"fetch_add, relaxed", [](const std::size_t threadCount) { return measureSharedCounter(threadCount, std::memory_order_relaxed); }},
+                         {"fetch_add, acq_rel", [](const std::size_t threadCount) { return measureSharedCounter(threadCount, std::memory_order_acq_rel); }},
+                         {"fetch_add, seq_cst", [](const std::size_t threadCount) { return measureSharedCounter(threadCount, std::memory_order_seq_cst); }},
+                         {"compare_exchange_weak loop, relaxed", measureSharedCounterWithCompareExchange}},
+                        threadCounts);
+  printObservedCacheLineSize();
+}
+} // namespace Experiments
@@ -1,3 +1,11 @@
+#pragma once
+
 namespace Experiments {
 void testSizesOfAtomicTypes();
-}
\ No newline at end of file
+
+/**
+ * Measures atomic increments from one thread up to all hardware threads, comparing packed and padded per-thread counters and the memory orders and compare
+ * and exchange loops on a shared counter, and observes the cache line size.
+ * */
+void testAtomicCounterContention();
+} // namespace Experiments
@@ -0,0 +1,202 @@
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+
+namespace Experiments {
+/**
+ * Positions written by different threads are aligned to this size, so that they do not share a cache line.
+ *
+ * This is not std::hardware_destructive_interference_size, whose value may differ between compilers and flags, which would change the layout of these types
+ * between translation units.
+ * */
+static constexpr std::size_t QueuePositionAlignment = 64;
+
+/**
+ * Throws std::invalid_argument if the capacity is not a power of two of at least two, which lets positions wrap around with a mask.
+ * */
+inline std::size_t checkQueueCapacity(const std::size_t capacity) {
+  if (capacity < 2 || !std::has_single_bit(capacity)) {
+    throw std::invalid_argument("The capacity of a queue must be a power of two of at least two.");
+  }
+  return capacity;
+}
+
+/**
+ * A bounded queue for any number of producers and consumers, in the style of the queue by Dmitry Vyukov.
+ *
+ * Each slot has a sequence number which tells whether it is ready to be written for the current lap around the ring or ready to be read. A producer claims
+ * a slot by advancing the enqueue position with a compare and exchange, writes the value and then publishes it by advancing the sequence number, and a
+ * consumer does the same with the dequeue position. Neither pushing nor popping allocates or takes a lock.
+ * */
+template <typename T> class BoundedMpmcQueue {
+  struct Slot {
+    std::atomic<std::size_t> sequence;
+    T value;
+  };
+
+  std::unique_ptr<Slot[]> slots;
+  std::size_t mask;
+  alignas(QueuePositionAlignment) std::atomic<std::size_t> enqueuePosition{0};
+  alignas(QueuePositionAlignment) std::atomic<std::size_t> dequeuePosition{0};
+
+public:
+  explicit BoundedMpmcQueue(const std::size_t capacity) : slots(std::make_unique<Slot[]>(checkQueueCapacity(capacity))), mask(capacity - 1) {
+    for (std::size_t i = 0; i < capacity; i++) {
+      slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  BoundedMpmcQueue(const BoundedMpmcQueue &) = delete;
+
+  BoundedMpmcQueue &operator=(const BoundedMpmcQueue &) = delete;
+
+  /**
+   * Returns false without waiting if the queue is full.
+   * */
+  bool tryPush(const T &value) {
+    auto position = enqueuePosition.load(std::memory_order_relaxed);
+    for (;;) {
+      auto &slot = slots[position & mask];
+      const auto sequence = slot.sequence.load(std::memory_order_acquire);
+      const auto difference = static_cast<std::ptrdiff_t>(sequence - position);
+      if (difference == 0) {
+        if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+          slot.value = value;
+          slot.sequence.store(position + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (difference < 0) {
+        // The slot still holds the value written a lap ago, which has not been read yet.
+        return false;
+      } else {
+        position = enqueuePosition.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  /**
+   * Returns false without waiting if the queue is empty.
+   * */
+  bool tryPop(T &value) {
+    auto position = dequeuePosition.load(std::memory_order_relaxed);
+    for (;;) {
+      auto &slot = slots[position & mask];
+      const auto sequence = slot.sequence.load(std::memory_order_acquire);
+      const auto difference = static_cast<std::ptrdiff_t>(sequence - (position + 1));
+      if (difference == 0) {
+        if (dequeuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+          value = std::move(slot.value);
+          slot.sequence.store(position + mask + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (difference < 0) {
+        return false;
+      } else {
+        position = dequeuePosition.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  [[nodiscard]] std::size_t capacity() const noexcept { return mask + 1; }
+};
+
+/**
+ * A bounded queue for a single producer and a single consumer.
+ *
+ * Each side only writes its own position, and keeps a copy of the position of the other side which it only refreshes when the queue looks full or empty,
+ * so that it rarely reads the cache line which the other side writes.
+ * */
+template <typename T> class BoundedSpscQueue {
+  std::unique_ptr<T[]> values;
+  std::size_t mask;
+  alignas(QueuePositionAlignment) std::atomic<std::size_t> writePosition{0};
+  std::size_t cachedReadPosition = 0;
+  alignas(QueuePositionAlignment) std::atomic<std::size_t> readPosition{0};
+  std::size_t cachedWritePosition = 0;
+
+public:
+  explicit BoundedSpscQueue(const std::size_t capacity) : values(std::make_unique<T[]>(checkQueueCapacity(capacity))), mask(capacity - 1) {}
+
+  BoundedSpscQueue(const BoundedSpscQueue &) = delete;
+
+  BoundedSpscQueue &operator=(const BoundedSpscQueue &) = delete;
+
+  /**
+   * Returns false without waiting if the queue is full. Only one thread may push.
+   * */
+  bool tryPush(const T &value) {
+    const auto position = writePosition.load(std::memory_order_relaxed);
+    if (position - cachedReadPosition > mask) {
+      cachedReadPosition = readPosition.load(std::memory_order_acquire);
+      if (position - cachedReadPosition > mask) {
+        return false;
+      }
+    }
+    values[position & mask] = value;
+    writePosition.store(position + 1, std::memory_order_release);
+    return true;
+  }
+
+  /**
+   * Returns false without waiting if the queue is empty. Only one thread may pop.
+   * */
+  bool tryPop(T &value) {
+    const auto position = readPosition.load(std::memory_order_relaxed);
+    if (position == cachedWritePosition) {
+      cachedWritePosition = writePosition.load(std::memory_order_acquire);
+      if (position == cachedWritePosition) {
+        return false;
+      }
+    }
+    value = std::move(values[position & mask]);
+    readPosition.store(position + 1, std::memory_order_release);
+    return true;
+  }
+
+  [[nodiscard]] std::size_t capacity() const noexcept { return mask + 1; }
+};
+
+/**
+ * A bounded queue which guards a std::deque with a std::mutex, as the baseline for the lock-free queues.
+ * */
+template <typename T> class LockedQueue {
+  std::mutex mutex;
+  std::deque<T> values;
+  std::size_t maximumSize;
+
+public:
+  explicit LockedQueue(const std::size_t capacity) : maximumSize(checkQueueCapacity(capacity)) {}
+
+  LockedQueue(const LockedQueue &) = delete;
+
+  LockedQueue &operator=(const LockedQueue &) = delete;
+
+  bool tryPush(const T &value) {
+    const std::scoped_lock lock(mutex);
+    if (values.size() == maximumSize) {
+      return false;
+    }
+    values.push_back(value);
+    return true;
+  }
+
+  bool tryPop(T &value) {
+    const std::scoped_lock lock(mutex);
+    if (values.empty()) {
+      return false;
+    }
+    value = std::move(values.front());
+    values.pop_front();
+    return true;
+  }
+
+  [[nodiscard]] std::size_t capacity() const noexcept { return maximumSize; }
+};
+} // namespace Experiments
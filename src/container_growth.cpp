@@ -1,12 +1,25 @@
 #include "container_growth.hpp"
 
+#include <algorithm>
+#include <array>
 #include <iomanip>
 #include <iostream>
+#include <numeric>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
 #include <unordered_set>
 #include <vector>
 
+#include "experiment_runner.hpp"
+#include "flat_hash_set.hpp"
 #include "formatting.hpp"
+#include "growth_vector.hpp"
 #include "memory.hpp"
+#include "results.hpp"
+#include "timing.hpp"
 #include "types.hpp"
 
 namespace Experiments {
@@ -15,33 +28,74 @@ static constexpr std::size_t TargetSize = 1'000'000;
 static constexpr std::size_t ReserveTargetSize = 50;
 static constexpr U32 CapacityWidth = 8; // std::log10(10 * 10 * TargetSize)
 
-template <typename T> void updateIfChangedAndNotify(T &lastT, const T newT) {
+/**
+ * Returns the factor by which the value grew, if it changed from a value other than zero.
+ * */
+template <typename T> std::optional<double> updateIfChangedAndNotify(T &lastT, const T newT) {
   if (lastT == newT) {
-    return;
+    return std::nullopt;
   }
+  std::optional<double> factor;
   std::cout << Indentation << std::setw(CapacityWidth) << newT;
   if (lastT != 0) {
-    const auto factor = newT / static_cast<double>(lastT);
-    std::cout << " (x" << toFixedPrecisionString(factor, FactorDecimalPlaces) << ")";
+    factor = newT / static_cast<double>(lastT);
+    std::cout << " (x" << toFixedPrecisionString(*factor, FactorDecimalPlaces) << ")";
   }
   std::cout << "\n";
   lastT = newT;
+  return factor;
+}
+
+/**
+ * Times inserting elements into a new container in a measured region, and then prints the capacities a second container goes through and returns what it
+ * allocated, so that neither the printing nor the allocation tracking is part of the region.
+ *
+ * Records the allocations and the last growth factor, which any change of the growth policy changes.
+ * */
+template <typename Container, typename Insert, typename GetCapacity>
+static AllocationStatistics testContainerGrowth(const std::string_view regionName, const Insert &insert, const GetCapacity &getCapacity) {
+  {
+    Container container;
+    MeasuredRegion measuredRegion(regionName, TargetSize);
+    for (std::size_t i = 0; i < TargetSize; i++) {
+      insert(container, i);
+    }
+  }
+  Container container;
+  auto lastCapacity = getCapacity(container);
+  std::optional<double> lastGrowthFactor;
+  AllocationStatistics statistics;
+  {
+    AllocationTrackerGuard allocationTrackerGuard(false, false, false, true);
+    for (std::size_t i = 0; i < TargetSize; i++) {
+      insert(container, i);
+      if (const auto growthFactor = updateIfChangedAndNotify(lastCapacity, getCapacity(container))) {
+        lastGrowthFactor = growthFactor;
+      }
+    }
+    statistics = allocationTrackerGuard.getStatistics();
+  }
+  recordResult(std::string(regionName) + " allocations", static_cast<double>(statistics.allocations), "allocations", MetricDirection::Exact);
+  if (lastGrowthFactor) {
+    recordResult(std::string(regionName) + " growth factor", *lastGrowthFactor, "x", MetricDirection::Exact);
+  }
+  return statistics;
 }
 
 void testVectorMaximumSize() {
   std::cout << "std::vector<bool> maximum size: " << toStringWithThousandsSeparators(std::vector<bool>().max_size()) << "\n";
   std::cout << "std::vector<int> maximum size: " << toStringWithThousandsSeparators(std::vector<int>().max_size()) << "\n";
+  recordResult("std::vector<bool> maximum size", static_cast<double>(std::vector<bool>().max_size()), "elements", MetricDirection::Exact);
+  recordResult("std::vector<int> maximum size", static_cast<double>(std::vector<int>().max_size()), "elements", MetricDirection::Exact);
 }
 
 void testVectorGrowth() {
-  std::vector<int> vector;
-  auto lastCapacity = vector.capacity();
   std::cout << "Testing std::vector growth.\n";
-  std::cout << Indentation << "It started with a capacity of " << lastCapacity << ".\n";
-  for (std::size_t i = 0; i < TargetSize; i++) {
-    vector.push_back(i);
-    updateIfChangedAndNotify(lastCapacity, vector.capacity());
-  }
+  std::cout << Indentation << "It started with a capacity of " << std::vector<int>().capacity() << ".\n";
+  const auto statistics = testContainerGrowth<std::vector<int>>(
+      "std::vector<int> push_back()", [](std::vector<int> &vector, const std::size_t i) { vector.push_back(static_cast<int>(i)); },
+      [](const std::vector<int> &vector) { return vector.capacity(); });
+  printMemoryUsage(statistics);
 }
 
 void testVectorReserveGrowth() {
@@ -54,7 +108,9 @@ void testVectorReserveGrowth() {
     vector.reserve(reserveSize);
     updateIfChangedAndNotify(lastCapacity, vector.capacity());
   }
-  if (allocationTrackerGuard.getAllocationsMade() >= ReserveTargetSize) {
+  const auto allocations = allocationTrackerGuard.getAllocationsMade();
+  recordResult("std::vector<int> reserve() allocations", static_cast<double>(allocations), "allocations", MetricDirection::Exact);
+  if (allocations >= ReserveTargetSize) {
     std::cout << Warning << "reserve() seems to reserve exactly the specified size.\n";
     std::cout << WarningIndentation
               << "This behavior will lead to quadratic performance if reserve() is regularly used before insertions of constant length.\n";
@@ -62,14 +118,209 @@ void testVectorReserveGrowth() {
 }
 
 void testUnorderedSetGrowth() {
-  std::unordered_set<int> set;
-  auto lastBucketCount = set.bucket_count();
+  const std::unordered_set<int> emptySet;
   std::cout << "Testing std::unordered_set growth.\n";
-  std::cout << Indentation << "It started with " << pluralizeAsNeeded(lastBucketCount, "bucket") << ".\n";
-  std::cout << Indentation << "Its default maximum load factor is " << set.max_load_factor() << ".\n";
-  for (std::size_t i = 0; i < TargetSize; i++) {
-    set.insert(i);
-    updateIfChangedAndNotify(lastBucketCount, set.bucket_count());
+  std::cout << Indentation << "It started with " << pluralizeAsNeeded(emptySet.bucket_count(), "bucket") << ".\n";
+  std::cout << Indentation << "Its default maximum load factor is " << emptySet.max_load_factor() << ".\n";
+  const auto statistics = testContainerGrowth<std::unordered_set<int>>(
+      "std::unordered_set<int> insert()", [](std::unordered_set<int> &set, const std::size_t i) { set.insert(static_cast<int>(i)); },
+      [](const std::unordered_set<int> &set) { return set.bucket_count(); });
+  printMemoryUsage(statistics);
+  printSizeClassHistogram(statistics);
+}
+
+void testFlatHashSetGrowth() {
+  static constexpr U32 BytesPerElementDecimalPlaces = 2;
+  const FlatHashSet<int> emptySet;
+  std::cout << "Testing FlatHashSet growth.\n";
+  std::cout << Indentation << "It started with " << pluralizeAsNeeded(emptySet.capacity(), "slot") << ".\n";
+  std::cout << Indentation << "Its maximum load factor is " << emptySet.maxLoadFactor() << ".\n";
+  const auto statistics = testContainerGrowth<FlatHashSet<int>>(
+      "FlatHashSet<int> insert()", [](FlatHashSet<int> &set, const std::size_t i) { set.insert(static_cast<int>(i)); },
+      [](const FlatHashSet<int> &set) { return set.capacity(); });
+  printMemoryUsage(statistics);
+  // The statistics were taken while the set still held every inserted element.
+  const auto bytesPerElement = static_cast<double>(statistics.getLiveBytes()) / static_cast<double>(TargetSize);
+  std::cout << Indentation << "It uses " << toFixedPrecisionString(bytesPerElement, BytesPerElementDecimalPlaces) << " bytes per element.\n";
+  recordResult("FlatHashSet<int> insert() bytes per element", bytesPerElement, "bytes/element");
+}
+
+/**
+ * Both sets are used through the same interface, which FlatHashSet shares with the standard sets.
+ * */
+template <typename Set> static void testHashSetThroughput(const std::string_view name, const std::vector<int> &keys, const std::vector<int> &missingKeys) {
+  static constexpr std::size_t Repetitions = 3;
+  static constexpr U32 BytesPerElementDecimalPlaces = 2;
+  static constexpr U32 ThroughputDecimalPlaces = 2;
+  static constexpr int OperationWidth = 18;
+  std::cout << Indentation << name << ":\n";
+  double bytesPerElement = 0.0;
+  {
+    AllocationTrackerGuard allocationTrackerGuard(false, false);
+    Set set;
+    for (const auto key : keys) {
+      set.insert(key);
+    }
+    bytesPerElement = static_cast<double>(allocationTrackerGuard.getStatistics().getLiveBytes()) / static_cast<double>(set.size());
+  }
+  std::cout << Indentation << Indentation << std::setw(OperationWidth) << std::left << "Memory" << std::right
+            << toFixedPrecisionString(bytesPerElement, BytesPerElementDecimalPlaces) << " bytes per element\n";
+  recordResult(std::string(name) + " memory", bytesPerElement, "bytes/element");
+  const auto printThroughput = [name, &keys](const std::string_view operation, const TimingStatistics &statistics) {
+    const auto millionsOfOperationsPerSecond = static_cast<double>(keys.size()) / statistics.median / 1e6;
+    std::cout << Indentation << Indentation << std::setw(OperationWidth) << std::left << operation << std::right
+              << toFixedPrecisionString(millionsOfOperationsPerSecond, ThroughputDecimalPlaces) << " million operations per second\n";
+    recordResult(std::string(name) + " " + std::string(operation), millionsOfOperationsPerSecond, "M operations/s", MetricDirection::HigherIsBetter);
+  };
+  Set set;
+  printThroughput("Insert", measureRepeatedly(
+                                Repetitions, [&set]() { set = Set(); },
+                                [&set, &keys]() {
+                                  for (const auto key : keys) {
+                                    set.insert(key);
+                                  }
+                                }));
+  std::size_t found = 0;
+  printThroughput("Successful find", measureRepeatedly(
+                                         Repetitions, [&found]() { found = 0; },
+                                         [&set, &keys, &found]() {
+                                           for (const auto key : keys) {
+                                             found += set.contains(key);
+                                           }
+                                         }));
+  if (found != keys.size()) {
+    throw std::logic_error(std::string(name) + " did not find the keys inserted into it.");
+  }
+  printThroughput("Failed find", measureRepeatedly(
+                                     Repetitions, [&found]() { found = 0; },
+                                     [&set, &missingKeys, &found]() {
+                                       for (const auto key : missingKeys) {
+                                         found += set.contains(key);
+                                       }
+                                     }));
+  if (found != 0) {
+    throw std::logic_error(std::string(name) + " found keys which were not inserted into it.");
+  }
+  printThroughput("Erase", measureRepeatedly(
+                               Repetitions,
+                               [&set, &keys]() {
+                                 for (const auto key : keys) {
+                                   set.insert(key);
+                                 }
+                               },
+                               [&set, &keys]() {
+                                 for (const auto key : keys) {
+                                   set.erase(key);
+                                 }
+                               }));
+  if (!set.empty()) {
+    throw std::logic_error(std::string(name) + " did not erase every key.");
+  }
+}
+
+void testHashSetThroughput() {
+  const auto elementCount = std::min(TargetSize, getExperimentOptions().maximumElementCount);
+  // The keys are distinct and shuffled, so that neither set benefits from the order of its elements matching the order of the operations.
+  std::vector<int> allKeys(2 * elementCount);
+  std::iota(std::begin(allKeys), std::end(allKeys), 0);
+  std::shuffle(std::begin(allKeys), std::end(allKeys), std::mt19937(0));
+  const std::vector<int> keys(std::begin(allKeys), std::begin(allKeys) + static_cast<std::ptrdiff_t>(elementCount));
+  const std::vector<int> missingKeys(std::begin(allKeys) + static_cast<std::ptrdiff_t>(elementCount), std::end(allKeys));
+  std::cout << "Testing hash set throughput with " << toStringWithThousandsSeparators(elementCount) << " shuffled int keys.\n";
+  testHashSetThroughput<std::unordered_set<int>>("std::unordered_set<int>", keys, missingKeys);
+  testHashSetThroughput<FlatHashSet<int>>("FlatHashSet<int>", keys, missingKeys);
+}
+
+namespace {
+struct PushBackResult {
+  double millionsOfElementsPerSecond;
+  GrowthStatistics statistics;
+};
+} // namespace
+
+template <typename Vector, typename MakeVector> static double measurePushBackThroughput(const std::size_t elementCount, const MakeVector &makeVector) {
+  static constexpr std::size_t Repetitions = 3;
+  std::optional<Vector> vector;
+  const auto timingStatistics = measureRepeatedly(
+      Repetitions,
+      [&vector, &makeVector]() {
+        vector.reset();
+        vector.emplace(makeVector());
+      },
+      [&vector, elementCount]() {
+        for (std::size_t i = 0; i < elementCount; i++) {
+          vector->push_back(static_cast<int>(i));
+        }
+      });
+  return static_cast<double>(elementCount) / timingStatistics.median / 1e6;
+}
+
+template <GrowthRelocation Relocation> static PushBackResult measureGrowthVectorPushBack(const std::size_t elementCount, const double growthFactor) {
+  PushBackResult result{};
+  result.millionsOfElementsPerSecond = measurePushBackThroughput<GrowthVector<int, Relocation>>(elementCount, [growthFactor]() {
+    return GrowthVector<int, Relocation>(growthFactor);
+  });
+  GrowthVector<int, Relocation> vector(growthFactor);
+  for (std::size_t i = 0; i < elementCount; i++) {
+    vector.push_back(static_cast<int>(i));
+  }
+  result.statistics = vector.getStatistics();
+  return result;
+}
+
+/**
+ * std::vector does not count its relocations, so they are counted by watching its capacity in a separate, untimed run.
+ * */
+static PushBackResult measureStandardVectorPushBack(const std::size_t elementCount) {
+  PushBackResult result{};
+  result.millionsOfElementsPerSecond = measurePushBackThroughput<std::vector<int>>(elementCount, []() { return std::vector<int>(); });
+  AllocationTrackerGuard allocationTrackerGuard(false, false, false, true);
+  std::vector<int> vector;
+  for (std::size_t i = 0; i < elementCount; i++) {
+    if (vector.size() == vector.capacity()) {
+      result.statistics.relocations++;
+      if (!vector.empty()) {
+        result.statistics.movedRelocations++;
+        result.statistics.bytesCopied += vector.size() * sizeof(int);
+      }
+    }
+    vector.push_back(static_cast<int>(i));
+  }
+  result.statistics.peakReservedBytes = allocationTrackerGuard.getStatistics().peakLiveBytes;
+  return result;
+}
+
+void testGrowthVectorPushBack() {
+  static constexpr std::size_t MaximumElementCount = 100'000'000;
+  static constexpr double GoldenRatio = 1.618033988749895;
+  static constexpr std::array<double, 3> GrowthFactors{1.5, GoldenRatio, 2.0};
+  static constexpr int NameWidth = 34;
+  static constexpr int ColumnWidth = 15;
+  static constexpr U32 ThroughputDecimalPlaces = 1;
+  const auto elementCount = std::min(MaximumElementCount, getExperimentOptions().maximumElementCount);
+  std::cout << "Testing push_back() of " << toStringWithThousandsSeparators(elementCount) << " int elements with different growth policies.\n";
+  std::cout << Indentation << std::setw(NameWidth) << std::left << "" << std::right << std::setw(ColumnWidth) << "Million/s" << std::setw(ColumnWidth)
+            << "Relocations" << std::setw(ColumnWidth) << "Moved" << std::setw(ColumnWidth) << "Bytes copied" << std::setw(ColumnWidth + 2) << "Peak bytes"
+            << "\n";
+  const auto printResult = [](const std::string &name, const PushBackResult &result) {
+    std::cout << Indentation << std::setw(NameWidth) << std::left << name << std::right << std::setw(ColumnWidth)
+              << toFixedPrecisionString(result.millionsOfElementsPerSecond, ThroughputDecimalPlaces) << std::setw(ColumnWidth)
+              << result.statistics.relocations << std::setw(ColumnWidth) << result.statistics.movedRelocations << std::setw(ColumnWidth)
+              << toStringWithThousandsSeparators(result.statistics.bytesCopied) << std::setw(ColumnWidth + 2)
+              << toStringWithThousandsSeparators(result.statistics.peakReservedBytes) << "\n";
+    // Which relocations move the buffer depends on the layout of the heap, so only the counts which the growth policy decides are recorded.
+    recordResult(name + " push_back()", result.millionsOfElementsPerSecond, "M elements/s", MetricDirection::HigherIsBetter);
+    recordResult(name + " relocations", static_cast<double>(result.statistics.relocations), "relocations", MetricDirection::Exact);
+    recordResult(name + " bytes copied", static_cast<double>(result.statistics.bytesCopied), "bytes");
+    recordResult(name + " peak bytes", static_cast<double>(result.statistics.peakReservedBytes), "bytes");
+  };
+  printResult("std::vector", measureStandardVectorPushBack(elementCount));
+  for (const auto growthFactor : GrowthFactors) {
+    const auto factorName = " x" + toFixedPrecisionString(growthFactor, 3);
+    printResult("GrowthVector, move" + factorName, measureGrowthVectorPushBack<GrowthRelocation::AllocateAndMove>(elementCount, growthFactor));
+    printResult("GrowthVector, realloc" + factorName, measureGrowthVectorPushBack<GrowthRelocation::Realloc>(elementCount, growthFactor));
+    printResult("GrowthVector, mremap" + factorName, measureGrowthVectorPushBack<GrowthRelocation::Mremap>(elementCount, growthFactor));
   }
+  std::cout << Indentation << "realloc may copy internally when it moves a buffer, which is not counted as bytes copied.\n";
 }
-} // namespace Experiments
\ No newline at end of file
+} // namespace Experiments
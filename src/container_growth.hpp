@@ -7,5 +7,18 @@ void testVectorGrowth();
 
 void testVectorReserveGrowth();
 
+/**
+ * Compares the push_back() throughput, relocations, bytes copied and peak memory of std::vector with GrowthVector for several growth factors and ways of
+ * relocating.
+ * */
+void testGrowthVectorPushBack();
+
 void testUnorderedSetGrowth();
+
+void testFlatHashSetGrowth();
+
+/**
+ * Compares the memory use and the insert, find and erase throughput of FlatHashSet with std::unordered_set.
+ * */
+void testHashSetThroughput();
 } // namespace Experiments
\ No newline at end of file
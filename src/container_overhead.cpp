@@ -0,0 +1,200 @@
+#include "container_overhead.hpp"
+
+#include <algorithm>
+#include <array>
+#include <compare>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <list>
+#include <map>
+#include <optional>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "experiment_runner.hpp"
+#include "formatting.hpp"
+#include "results.hpp"
+#include "tracking_allocator.hpp"
+#include "types.hpp"
+
+namespace Experiments {
+namespace {
+/**
+ * An element of the given size, which holds as many bytes of its index as fit into it.
+ * */
+template <std::size_t Size> struct Element {
+  std::array<U8, Size> bytes{};
+
+  Element() = default;
+
+  explicit Element(const U64 index) noexcept { std::memcpy(bytes.data(), &index, std::min(Size, sizeof(index))); }
+
+  auto operator<=>(const Element &) const = default;
+};
+
+template <std::size_t Size> struct ElementHash {
+  std::size_t operator()(const Element<Size> &element) const noexcept {
+    U64 index = 0;
+    std::memcpy(&index, element.bytes.data(), std::min(Size, sizeof(index)));
+    return std::hash<U64>()(index);
+  }
+};
+
+struct ContainerFootprint {
+  double bytesPerElement;
+  /**
+   * The most bytes held at once while filling the container, which exceeds the bytes it holds once full when growing copies into a new buffer.
+   * */
+  double peakBytesPerElement;
+  double allocationsPerElement;
+};
+
+template <std::size_t Size> using Vector = std::vector<Element<Size>, TrackingAllocator<Element<Size>>>;
+
+template <std::size_t Size> using Deque = std::deque<Element<Size>, TrackingAllocator<Element<Size>>>;
+
+template <std::size_t Size> using List = std::list<Element<Size>, TrackingAllocator<Element<Size>>>;
+
+template <std::size_t Size> using Map = std::map<U64, Element<Size>, std::less<>, TrackingAllocator<std::pair<const U64, Element<Size>>>>;
+
+template <std::size_t Size> using Set = std::set<Element<Size>, std::less<>, TrackingAllocator<Element<Size>>>;
+
+template <std::size_t Size>
+using UnorderedMap = std::unordered_map<U64, Element<Size>, std::hash<U64>, std::equal_to<>, TrackingAllocator<std::pair<const U64, Element<Size>>>>;
+
+template <std::size_t Size> using UnorderedSet = std::unordered_set<Element<Size>, ElementHash<Size>, std::equal_to<>, TrackingAllocator<Element<Size>>>;
+
+template <typename Container> struct ContainerName;
+
+template <typename T, typename Allocator> struct ContainerName<std::vector<T, Allocator>> {
+  static constexpr std::string_view Value = "std::vector";
+};
+
+template <typename T, typename Allocator> struct ContainerName<std::deque<T, Allocator>> {
+  static constexpr std::string_view Value = "std::deque";
+};
+
+template <typename T, typename Allocator> struct ContainerName<std::list<T, Allocator>> {
+  static constexpr std::string_view Value = "std::list";
+};
+
+template <typename Key, typename T, typename Compare, typename Allocator> struct ContainerName<std::map<Key, T, Compare, Allocator>> {
+  static constexpr std::string_view Value = "std::map";
+};
+
+template <typename T, typename Compare, typename Allocator> struct ContainerName<std::set<T, Compare, Allocator>> {
+  static constexpr std::string_view Value = "std::set";
+};
+
+template <typename Key, typename T, typename Hash, typename Equal, typename Allocator>
+struct ContainerName<std::unordered_map<Key, T, Hash, Equal, Allocator>> {
+  static constexpr std::string_view Value = "std::unordered_map";
+};
+
+template <typename T, typename Hash, typename Equal, typename Allocator> struct ContainerName<std::unordered_set<T, Hash, Equal, Allocator>> {
+  static constexpr std::string_view Value = "std::unordered_set";
+};
+} // namespace
+
+[[nodiscard]] static constexpr U64 getDistinctElementCount(const std::size_t size) noexcept {
+  if (size >= sizeof(U64)) {
+    return std::numeric_limits<U64>::max();
+  }
+  return U64{1} << (std::numeric_limits<U8>::digits * size);
+}
+
+/**
+ * Fills a container with distinct elements, appending to sequences and inserting into sets and maps, and returns what it holds allocated per element once
+ * it is full.
+ *
+ * A set can only hold as many elements as there are distinct values of the element, so nothing is returned for sets of more.
+ * */
+template <typename Container, std::size_t Size> static std::optional<ContainerFootprint> measureContainerFootprint(const std::size_t elementCount) {
+  static constexpr auto IsSequence = requires(Container &container) { container.push_back(Element<Size>()); };
+  static constexpr auto IsMap = requires { typename Container::mapped_type; };
+  if constexpr (!IsSequence && !IsMap) {
+    if (Size < sizeof(U64) && elementCount > getDistinctElementCount(Size)) {
+      return std::nullopt;
+    }
+  }
+  AllocationStatistics statistics;
+  ContainerFootprint footprint{};
+  {
+    Container container{TrackingAllocator<typename Container::value_type>(statistics)};
+    for (std::size_t i = 0; i < elementCount; i++) {
+      if constexpr (IsSequence) {
+        container.push_back(Element<Size>(i));
+      } else if constexpr (IsMap) {
+        container.emplace(i, Element<Size>(i));
+      } else {
+        container.insert(Element<Size>(i));
+      }
+    }
+    footprint.bytesPerElement = static_cast<double>(statistics.getLiveBytes()) / static_cast<double>(elementCount);
+    footprint.peakBytesPerElement = static_cast<double>(statistics.peakLiveBytes) / static_cast<double>(elementCount);
+    footprint.allocationsPerElement = static_cast<double>(statistics.allocations) / static_cast<double>(elementCount);
+  }
+  if (statistics.getLiveBytes() != 0) {
+    throw std::logic_error("A container did not free everything it allocated through its allocator.");
+  }
+  return footprint;
+}
+
+template <template <std::size_t> typename Container, std::size_t... Sizes> static void printContainerFootprints(const std::size_t elementCount) {
+  static constexpr int NameWidth = 20;
+  static constexpr int ColumnWidth = 24;
+  static constexpr U32 BytesDecimalPlaces = 1;
+  static constexpr U32 AllocationsDecimalPlaces = 3;
+  static constexpr auto Name = ContainerName<Container<1>>::Value;
+  std::cout << Indentation << std::setw(NameWidth) << std::left << Name << std::right;
+  const auto printFootprint = [elementCount](const std::size_t size, const std::optional<ContainerFootprint> &footprint) {
+    if (!footprint) {
+      std::cout << std::setw(ColumnWidth) << "-";
+      return;
+    }
+    std::cout << std::setw(ColumnWidth)
+              << toFixedPrecisionString(footprint->bytesPerElement, BytesDecimalPlaces) + " / " +
+                     toFixedPrecisionString(footprint->peakBytesPerElement, BytesDecimalPlaces) + " / " +
+                     toFixedPrecisionString(footprint->allocationsPerElement, AllocationsDecimalPlaces);
+    const auto metric = std::string(Name) + " of " + std::to_string(elementCount) + " " + std::to_string(size) + "-byte elements";
+    recordResult(metric + ", bytes", footprint->bytesPerElement, "bytes/element");
+    recordResult(metric + ", peak bytes", footprint->peakBytesPerElement, "bytes/element");
+    recordResult(metric + ", allocations", footprint->allocationsPerElement, "allocations/element");
+  };
+  (printFootprint(Sizes, measureContainerFootprint<Container<Sizes>, Sizes>(elementCount)), ...);
+  std::cout << "\n";
+}
+
+template <template <std::size_t> typename... Containers> static void printContainerFootprintRows(const std::size_t elementCount) {
+  (printContainerFootprints<Containers, 1, 8, 32, 128>(elementCount), ...);
+}
+
+void testContainerMemoryOverhead() {
+  static constexpr std::size_t MaximumElementCount = 1'000'000;
+  static constexpr std::size_t ElementCountStep = 100;
+  static constexpr int NameWidth = 20;
+  static constexpr int ColumnWidth = 24;
+  const auto maximumElementCount = std::min(MaximumElementCount, getExperimentOptions().maximumElementCount);
+  std::cout << "Testing the memory overhead of containers, counted by their allocators.\n";
+  std::cout << Indentation << "Each column shows the bytes held once full, the peak bytes held while filling, and the allocations, all per element.\n";
+  std::cout << Indentation << "Maps map 8-byte integers to elements of the given size, and sets of 1-byte elements hold at most 256 elements.\n";
+  for (std::size_t elementCount = 1; elementCount <= maximumElementCount; elementCount *= ElementCountStep) {
+    std::cout << Indentation << toStringWithThousandsSeparators(elementCount) << (elementCount == 1 ? " element" : " elements") << ":\n";
+    std::cout << Indentation << std::setw(NameWidth) << "";
+    for (const auto size : {1, 8, 32, 128}) {
+      std::cout << std::setw(ColumnWidth) << std::to_string(size) + "-byte";
+    }
+    std::cout << "\n";
+    printContainerFootprintRows<Vector, Deque, List, Map, Set, UnorderedMap, UnorderedSet>(elementCount);
+  }
+}
+} // namespace Experiments
@@ -0,0 +1,9 @@
+#pragma once
+
+namespace Experiments {
+/**
+ * Reports the bytes held, the peak bytes held while filling, and the allocations per element of the standard containers for several element sizes and
+ * element counts, counted with TrackingAllocator.
+ * */
+void testContainerMemoryOverhead();
+} // namespace Experiments
@@ -1,17 +1,485 @@
 #include "experiment_runner.hpp"
 
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <charconv>
+#include <fstream>
 #include <iostream>
+#include <limits>
+#include <sstream>
 #include <stdexcept>
+#include <string_view>
+#include <system_error>
+
+#include <sys/wait.h>
+#include <unistd.h>
 
 #include "formatting.hpp"
+#include "performance_counters.hpp"
+#include "results.hpp"
+#include "timing.hpp"
 
 namespace Experiments {
-void ExperimentRunner::run() noexcept {
+static ExperimentOptions activeExperimentOptions;
+
+[[nodiscard]] static std::size_t parseInteger(const std::string_view option, const std::string_view value, const std::size_t minimum) {
+  std::size_t integer = 0;
+  const auto [end, error] = std::from_chars(value.data(), value.data() + value.size(), integer);
+  if (error != std::errc{} || end != value.data() + value.size() || integer < minimum) {
+    throw std::invalid_argument(std::string(option) + " expects an integer of at least " + std::to_string(minimum) + ", but got \"" + std::string(value) +
+                                "\".");
+  }
+  return integer;
+}
+
+[[nodiscard]] static AllocationTraceFormat parseAllocationTraceFormat(const std::string_view value) {
+  if (value == "csv") {
+    return AllocationTraceFormat::Csv;
+  }
+  if (value == "binary") {
+    return AllocationTraceFormat::Binary;
+  }
+  if (value == "messages") {
+    return AllocationTraceFormat::Messages;
+  }
+  throw std::invalid_argument("--allocation-trace-format expects csv, binary, or messages, but got \"" + std::string(value) + "\".");
+}
+
+ExperimentOptions parseExperimentOptions(const int argc, const char *const *const argv) {
+  ExperimentOptions options;
+  for (int i = 1; i < argc; i++) {
+    const std::string_view argument = argv[i];
+    const auto separator = argument.find('=');
+    const auto option = argument.substr(0, separator);
+    const auto value = separator == std::string_view::npos ? std::string_view{} : argument.substr(separator + 1);
+    if (option == "--experiment") {
+      if (value.empty()) {
+        throw std::invalid_argument("--experiment expects the name of an experiment.");
+      }
+      options.selectedExperiments.emplace_back(value);
+    } else if (option == "--maximum-elements") {
+      options.maximumElementCount = parseInteger(option, value, 1);
+    } else if (option == "--maximum-working-set") {
+      static constexpr unsigned BytesPerMebibyteShift = 20;
+      const auto mebibytes = parseInteger(option, value, 1);
+      if (mebibytes > std::numeric_limits<std::size_t>::max() >> BytesPerMebibyteShift) {
+        throw std::invalid_argument("--maximum-working-set expects a number of MiB which fits in memory, but got \"" + std::string(value) + "\".");
+      }
+      options.maximumWorkingSetSize = mebibytes << BytesPerMebibyteShift;
+    } else if (option == "--benchmark") {
+      options.benchmark = true;
+    } else if (option == "--warmup-runs") {
+      options.warmupRuns = parseInteger(option, value, 0);
+    } else if (option == "--repetitions") {
+      options.repetitions = parseInteger(option, value, 1);
+    } else if (option == "--jobs") {
+      options.jobs = parseInteger(option, value, 1);
+    } else if (option == "--performance-counters") {
+      options.performanceCounters = true;
+    } else if (option == "--allocation-trace") {
+      if (value.empty()) {
+        throw std::invalid_argument("--allocation-trace expects a directory.");
+      }
+      options.allocationTraceDirectory = value;
+    } else if (option == "--allocation-trace-format") {
+      options.allocationTraceFormat = parseAllocationTraceFormat(value);
+    } else if (option == "--allocation-trace-capacity") {
+      options.allocationTraceCapacity = parseInteger(option, value, 1);
+    } else if (option == "--results" || option == "--baseline") {
+      if (value.empty()) {
+        throw std::invalid_argument(std::string(option) + " expects a .json or .csv file.");
+      }
+      static_cast<void>(getResultFormat(value));
+      (option == "--results" ? options.resultsPath : options.baselinePath) = value;
+    } else if (option == "--regression-threshold") {
+      static constexpr double PercentPerFraction = 100.0;
+      options.regressionThreshold = static_cast<double>(parseInteger(option, value, 0)) / PercentPerFraction;
+    } else {
+      throw std::invalid_argument("Unknown option \"" + std::string(argument) + "\".");
+    }
+  }
+  return options;
+}
+
+std::string getExperimentOptionsUsage() {
+  std::string usage = "Options:\n";
+  usage += "  --experiment=NAME                      only run the experiment NAME, may be given more than once\n";
+  usage += "  --jobs=JOBS                            run up to JOBS experiments at once, each in its own process\n";
+  usage += "  --maximum-elements=COUNT               largest input size of experiments which sweep over sizes, 1000000 by default\n";
+  usage += "  --maximum-working-set=MIB              largest working set of experiments which sweep over memory sizes, 256 by default\n";
+  usage += "  --benchmark                            time the measured regions of the experiments over several silent runs\n";
+  usage += "  --warmup-runs=RUNS                     silent runs before the timed ones when benchmarking, 1 by default\n";
+  usage += "  --repetitions=RUNS                     timed runs when benchmarking, 5 by default\n";
+  usage += "  --performance-counters                 report hardware performance counters and page faults\n";
+  usage += "  --allocation-trace=DIRECTORY           trace the allocations of each experiment into a file in DIRECTORY\n";
+  usage += "  --allocation-trace-format=FORMAT       csv (default), binary, or messages\n";
+  usage += "  --allocation-trace-capacity=EVENTS     events kept per experiment, older events are overwritten\n";
+  usage += "  --results=FILE                         write the recorded results to FILE, which ends in .json or .csv\n";
+  usage += "  --baseline=FILE                        flag the results which regressed from those in FILE, and fail if any did\n";
+  usage += "  --regression-threshold=PERCENT         how much worse than the baseline a result may be, 5 by default\n";
+  return usage;
+}
+
+bool isExperimentSelected(const ExperimentOptions &options, const std::string &name) {
+  const auto &selected = options.selectedExperiments;
+  return selected.empty() || std::find(std::begin(selected), std::end(selected), name) != std::end(selected);
+}
+
+[[nodiscard]] static std::string_view getAllocationTraceExtension(const AllocationTraceFormat format) {
+  switch (format) {
+  case AllocationTraceFormat::Csv:
+    return ".csv";
+  case AllocationTraceFormat::Binary:
+    return ".bin";
+  case AllocationTraceFormat::Messages:
+    return ".txt";
+  }
+  return "";
+}
+
+static void writeAllocationTrace(const AllocationTraceRecorder &recorder, const std::string &name, const ExperimentOptions &options) {
+  const auto format = options.allocationTraceFormat;
+  auto path = *options.allocationTraceDirectory / name;
+  path += getAllocationTraceExtension(format);
+  std::ofstream stream(path, format == AllocationTraceFormat::Binary ? std::ios::binary : std::ios::openmode{});
+  if (!stream) {
+    throw std::runtime_error("Could not open " + path.string() + " for writing.");
+  }
+  switch (format) {
+  case AllocationTraceFormat::Csv:
+    recorder.writeCsv(stream);
+    break;
+  case AllocationTraceFormat::Binary:
+    recorder.writeBinary(stream);
+    break;
+  case AllocationTraceFormat::Messages:
+    recorder.writeMessages(stream);
+    break;
+  }
+  const auto retainedEventCount = recorder.getRetainedEventCount();
+  std::cout << "Wrote " << pluralizeAsNeeded(retainedEventCount, "allocation event") << " to " << path.string();
+  if (recorder.getOverwrittenEventCount() != 0) {
+    std::cout << ", " << recorder.getOverwrittenEventCount() << " older events were overwritten";
+  }
+  if (const auto droppedEventCount = recorder.getEventCount() - recorder.getOverwrittenEventCount() - retainedEventCount; droppedEventCount != 0) {
+    std::cout << ", " << droppedEventCount << " events were dropped as their slot was still being written";
+  }
+  std::cout << ".\n";
+}
+
+namespace {
+/**
+ * Discards everything written to std::cout while it is alive.
+ * */
+class StandardOutputSilencer {
+  class NullBuffer : public std::streambuf {
+  protected:
+    int overflow(int character) override { return traits_type::not_eof(character); }
+    std::streamsize xsputn(const char *, std::streamsize count) override { return count; }
+  };
+
+  NullBuffer nullBuffer;
+  std::streambuf *originalBuffer;
+
+public:
+  StandardOutputSilencer() : originalBuffer(std::cout.rdbuf(&nullBuffer)) {}
+
+  StandardOutputSilencer(const StandardOutputSilencer &) = delete;
+
+  StandardOutputSilencer &operator=(const StandardOutputSilencer &) = delete;
+
+  ~StandardOutputSilencer() { std::cout.rdbuf(originalBuffer); }
+};
+} // namespace
+
+void ExperimentRunner::printPerformanceCounters(const PerformanceCounters &performanceCounters) const {
+  std::cout << "Performance counters of " << experimentName << ":\n";
+  if (!performanceCounters.getUnavailabilityReason().empty()) {
+    std::cout << Indentation << "Some hardware counters are unavailable and are not reported: " << performanceCounters.getUnavailabilityReason() << ".\n";
+  }
+  printPerformanceCounterReadings(performanceCounters.read());
+}
+
+std::vector<ResultRecord> ExperimentRunner::benchmark(const ExperimentOptions &options) const {
+  std::vector<MeasuredRegionSamples> samples;
+  {
+    StandardOutputSilencer standardOutputSilencer;
+    for (std::size_t i = 0; i < options.warmupRuns; i++) {
+      experimentFunction();
+    }
+    MeasuredRegionRecorder measuredRegionRecorder(options.performanceCounters);
+    for (std::size_t i = 0; i < options.repetitions; i++) {
+      experimentFunction();
+    }
+    samples = measuredRegionRecorder.takeSamples();
+  }
+  std::cout << "Timings of " << experimentName << " over " << pluralizeAsNeeded(options.repetitions, "run") << " after ";
+  std::cout << pluralizeAsNeeded(options.warmupRuns, "warm-up run") << ":\n";
+  std::vector<ResultRecord> records;
+  for (const auto &regionSamples : samples) {
+    printTimingStatistics(regionSamples);
+    records.push_back({experimentName, regionSamples.name + ", median", computeTimingStatistics(regionSamples.durations).median, "s"});
+  }
+  return records;
+}
+
+ExperimentOutcome ExperimentRunner::run(const ExperimentOptions &options) const noexcept {
+  ExperimentOutcome outcome;
+  auto &records = outcome.records;
   try {
-    experimentFunction();
+    // The first run is not timed, but tells whether the experiment has any region worth timing.
+    const auto endedMeasuredRegionCountAtStart = getEndedMeasuredRegionCount();
+    {
+      std::optional<AllocationTraceRecorder> optionalAllocationTraceRecorder;
+      if (options.allocationTraceDirectory) {
+        optionalAllocationTraceRecorder.emplace(options.allocationTraceCapacity);
+      }
+      std::optional<PerformanceCounters> optionalPerformanceCounters;
+      if (options.performanceCounters) {
+        optionalPerformanceCounters.emplace();
+        optionalPerformanceCounters->start();
+      }
+      {
+        ResultRecorder resultRecorder(experimentName);
+        try {
+          experimentFunction();
+        } catch (...) {
+          records = resultRecorder.takeRecords();
+          throw;
+        }
+        records = resultRecorder.takeRecords();
+      }
+      if (optionalPerformanceCounters) {
+        optionalPerformanceCounters->stop();
+        printPerformanceCounters(*optionalPerformanceCounters);
+      }
+      if (optionalAllocationTraceRecorder) {
+        optionalAllocationTraceRecorder->stop();
+        writeAllocationTrace(*optionalAllocationTraceRecorder, experimentName, options);
+      }
+    }
+    if (options.benchmark && getEndedMeasuredRegionCount() != endedMeasuredRegionCountAtStart) {
+      auto benchmarkRecords = benchmark(options);
+      records.insert(std::end(records), std::begin(benchmarkRecords), std::end(benchmarkRecords));
+    }
   } catch (const std::exception &any) {
     std::cerr << "An experiment threw:\n";
     std::cerr << Indentation << getPrettyTypeName<decltype(any)>() << ": " << any.what() << "\n";
+    outcome.succeeded = false;
+  }
+  return outcome;
+}
+
+namespace {
+struct ExperimentProcess {
+  std::size_t experimentIndex;
+  pid_t processId;
+  std::FILE *output;
+  /**
+   * The child writes the results it recorded here as CSV, separately from its output.
+   * */
+  std::FILE *results;
+};
+
+struct ExperimentProcessOutcome {
+  std::string output;
+  ExperimentOutcome outcome;
+};
+} // namespace
+
+[[nodiscard]] static ExperimentProcess startExperimentProcess(const ExperimentRunner &experimentRunner, const std::size_t experimentIndex,
+                                                             const ExperimentOptions &options) {
+  std::FILE *output = std::tmpfile();
+  std::FILE *results = std::tmpfile();
+  if (output == nullptr || results == nullptr) {
+    if (output != nullptr) {
+      std::fclose(output);
+    }
+    if (results != nullptr) {
+      std::fclose(results);
+    }
+    throw std::runtime_error("Could not create temporary files for the output of " + experimentRunner.getName() + ".");
+  }
+  // Anything still buffered would otherwise be written by the child as well.
+  std::cout.flush();
+  std::cerr.flush();
+  std::fflush(nullptr);
+  const auto processId = fork();
+  if (processId == -1) {
+    std::fclose(output);
+    std::fclose(results);
+    throw std::runtime_error("Could not fork a process for " + experimentRunner.getName() + ".");
+  }
+  if (processId == 0) {
+    dup2(fileno(output), STDOUT_FILENO);
+    dup2(fileno(output), STDERR_FILENO);
+    const auto outcome = experimentRunner.run(options);
+    std::ostringstream resultsStream;
+    writeResults(resultsStream, outcome.records, ResultFormat::Csv);
+    const auto resultsText = resultsStream.str();
+    std::fwrite(resultsText.data(), 1, resultsText.size(), results);
+    std::cout.flush();
+    std::cerr.flush();
+    std::fflush(nullptr);
+    // Exiting without running destructors, as the parent still owns everything the child inherited.
+    _exit(outcome.succeeded ? EXIT_SUCCESS : EXIT_FAILURE);
+  }
+  return {experimentIndex, processId, output, results};
+}
+
+/**
+ * Reads the whole file from its start and closes it.
+ * */
+[[nodiscard]] static std::string readAndCloseFile(std::FILE *const file) {
+  std::string contents;
+  std::rewind(file);
+  std::array<char, 4096> buffer{};
+  std::size_t bytesRead = 0;
+  while ((bytesRead = std::fread(buffer.data(), 1, buffer.size(), file)) != 0) {
+    contents.append(buffer.data(), bytesRead);
+  }
+  std::fclose(file);
+  return contents;
+}
+
+[[nodiscard]] static ExperimentProcessOutcome finishExperimentProcess(const ExperimentProcess &process, const int status) {
+  ExperimentProcessOutcome processOutcome;
+  auto &output = processOutcome.output;
+  auto &outcome = processOutcome.outcome;
+  output = readAndCloseFile(process.output);
+  // A child which crashed may have written no results, or only some of them.
+  std::istringstream resultsStream(readAndCloseFile(process.results));
+  try {
+    outcome.records = readResults(resultsStream, ResultFormat::Csv);
+  } catch (const std::runtime_error &) {
+    output += "The results of the experiment process could not be read.\n";
+    outcome.succeeded = false;
+  }
+  if (WIFSIGNALED(status)) {
+    output += "The experiment process was terminated by signal " + std::to_string(WTERMSIG(status)) + ".\n";
+  } else if (WIFEXITED(status) && WEXITSTATUS(status) != EXIT_SUCCESS) {
+    output += "The experiment process exited with status " + std::to_string(WEXITSTATUS(status)) + ".\n";
+  }
+  // The child exits with EXIT_FAILURE if its experiment threw.
+  if (!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS) {
+    outcome.succeeded = false;
+  }
+  return processOutcome;
+}
+
+/**
+ * Waits for any child process to exit, retrying when a signal interrupts the wait, and returns its process identifier.
+ * */
+[[nodiscard]] static pid_t waitForChildProcess(int &status) {
+  pid_t processId = -1;
+  do {
+    processId = waitpid(-1, &status, 0);
+  } while (processId == -1 && errno == EINTR);
+  if (processId == -1) {
+    throw std::system_error(errno, std::generic_category(), "Could not wait for the experiment processes");
+  }
+  return processId;
+}
+
+/**
+ * Kills and reaps the processes and closes their files, so that no process outlives a run which failed.
+ * */
+static void abandonExperimentProcesses(const std::vector<ExperimentProcess> &processes) noexcept {
+  for (const auto &process : processes) {
+    kill(process.processId, SIGKILL);
+    while (waitpid(process.processId, nullptr, 0) == -1 && errno == EINTR) {
+    }
+    std::fclose(process.output);
+    std::fclose(process.results);
+  }
+}
+
+/**
+ * Returns the outcomes of the experiments in the order in which they were given.
+ * */
+[[nodiscard]] static std::vector<ExperimentOutcome> runExperimentsInProcesses(const std::vector<const ExperimentRunner *> &experimentRunners,
+                                                                              const ExperimentOptions &options) {
+  std::vector<std::optional<std::string>> outputs(experimentRunners.size());
+  std::vector<ExperimentOutcome> outcomes(experimentRunners.size());
+  std::vector<ExperimentProcess> runningProcesses;
+  std::size_t nextExperiment = 0;
+  std::size_t nextOutput = 0;
+  try {
+    while (nextOutput < experimentRunners.size()) {
+      while (runningProcesses.size() < options.jobs && nextExperiment < experimentRunners.size()) {
+        runningProcesses.push_back(startExperimentProcess(*experimentRunners[nextExperiment], nextExperiment, options));
+        nextExperiment++;
+      }
+      int status = 0;
+      const auto processId = waitForChildProcess(status);
+      const auto isFinishedProcess = [processId](const ExperimentProcess &process) { return process.processId == processId; };
+      const auto process = std::find_if(std::begin(runningProcesses), std::end(runningProcesses), isFinishedProcess);
+      if (process == std::end(runningProcesses)) {
+        continue;
+      }
+      // The process is removed first, as finishing it closes its files, which abandoning it must not close again.
+      const auto finishedProcess = *process;
+      runningProcesses.erase(process);
+      auto processOutcome = finishExperimentProcess(finishedProcess, status);
+      outputs[finishedProcess.experimentIndex] = std::move(processOutcome.output);
+      outcomes[finishedProcess.experimentIndex] = std::move(processOutcome.outcome);
+      while (nextOutput < outputs.size() && outputs[nextOutput]) {
+        std::cout << *outputs[nextOutput] << std::flush;
+        outputs[nextOutput].reset();
+        nextOutput++;
+      }
+    }
+  } catch (...) {
+    abandonExperimentProcesses(runningProcesses);
+    throw;
+  }
+  return outcomes;
+}
+
+const ExperimentOptions &getExperimentOptions() noexcept { return activeExperimentOptions; }
+
+bool runExperiments(const std::vector<ExperimentRunner> &experimentRunners, const ExperimentOptions &options) {
+  activeExperimentOptions = options;
+  // The baseline is read first, so that a missing baseline does not waste a whole run.
+  std::vector<ResultRecord> baseline;
+  if (options.baselinePath) {
+    baseline = readResultsFile(*options.baselinePath);
+  }
+  // The metrics of the experiments which are not run are not expected in the results.
+  std::erase_if(baseline, [&options](const ResultRecord &record) { return !isExperimentSelected(options, record.experiment); });
+  std::vector<const ExperimentRunner *> selectedExperimentRunners;
+  for (const auto &experimentRunner : experimentRunners) {
+    if (isExperimentSelected(options, experimentRunner.getName())) {
+      selectedExperimentRunners.push_back(&experimentRunner);
+    }
+  }
+  std::vector<ExperimentOutcome> outcomes;
+  if (options.jobs > 1) {
+    outcomes = runExperimentsInProcesses(selectedExperimentRunners, options);
+  } else {
+    for (const auto *experimentRunner : selectedExperimentRunners) {
+      outcomes.push_back(experimentRunner->run(options));
+    }
+  }
+  std::vector<ResultRecord> records;
+  std::vector<std::string> failedExperiments;
+  for (std::size_t i = 0; i < outcomes.size(); i++) {
+    records.insert(std::end(records), std::begin(outcomes[i].records), std::end(outcomes[i].records));
+    if (!outcomes[i].succeeded) {
+      failedExperiments.push_back(selectedExperimentRunners[i]->getName());
+    }
+  }
+  if (options.resultsPath) {
+    writeResultsFile(*options.resultsPath, records);
+    std::cout << "Wrote " << pluralizeAsNeeded(records.size(), "result") << " to " << options.resultsPath->string() << ".\n";
+  }
+  const auto regressed = options.baselinePath && compareWithBaseline(baseline, records, options.regressionThreshold);
+  if (!failedExperiments.empty()) {
+    std::cerr << pluralizeAsNeeded(failedExperiments.size(), "experiment") << " failed: " << enumerate(failedExperiments) << ".\n";
   }
+  return !regressed && failedExperiments.empty();
 }
-} // namespace Experiments
\ No newline at end of file
+} // namespace Experiments
@@ -1,15 +1,114 @@
 #pragma once
 
+#include <cstddef>
+#include <filesystem>
 #include <functional>
+#include <optional>
+#include <string>
 #include <utility>
+#include <vector>
+
+#include "memory.hpp"
+#include "performance_counters.hpp"
+#include "results.hpp"
 
 namespace Experiments {
+enum class AllocationTraceFormat { Csv, Binary, Messages };
+
+struct ExperimentOptions {
+  /**
+   * If not empty, only the experiments with these names are run.
+   * */
+  std::vector<std::string> selectedExperiments;
+  /**
+   * If set, experiments with measured regions are run again silently, first to warm up and then to time their measured regions.
+   * */
+  bool benchmark = false;
+  std::size_t warmupRuns = 1;
+  std::size_t repetitions = 5;
+  /**
+   * If set, hardware performance counters and page faults are reported for each experiment, and for each measured region when benchmarking.
+   * */
+  bool performanceCounters = false;
+  /**
+   * If greater than one, each experiment runs in its own forked process, with up to this many processes at once, so experiments neither wait for nor
+   * share global state, such as allocation counters, with each other. Their output is still printed in order.
+   * */
+  std::size_t jobs = 1;
+  /**
+   * The largest number of elements which experiments that sweep over input sizes go up to.
+   * */
+  std::size_t maximumElementCount = 1'000'000;
+  /**
+   * The largest working set, in bytes, which experiments that sweep over memory sizes go up to.
+   * */
+  std::size_t maximumWorkingSetSize = std::size_t{256} << 20u;
+  /**
+   * If set, the allocations of each experiment are traced and written to a file named after the experiment in this directory.
+   * */
+  std::optional<std::filesystem::path> allocationTraceDirectory;
+  AllocationTraceFormat allocationTraceFormat = AllocationTraceFormat::Csv;
+  std::size_t allocationTraceCapacity = AllocationTraceRecorder::DefaultCapacity;
+  /**
+   * If set, the results the experiments record, and the median durations of their measured regions when benchmarking, are written to this file.
+   * */
+  std::optional<std::filesystem::path> resultsPath;
+  /**
+   * If set, the results are compared with the results in this file, which was written with resultsPath.
+   * */
+  std::optional<std::filesystem::path> baselinePath;
+  /**
+   * The fraction of its baseline value by which a metric must get worse to be flagged as a regression.
+   * */
+  double regressionThreshold = 0.05;
+};
+
+/**
+ * Throws std::invalid_argument if the arguments are not valid.
+ * */
+[[nodiscard]] ExperimentOptions parseExperimentOptions(int argc, const char *const *argv);
+
+[[nodiscard]] std::string getExperimentOptionsUsage();
+
+[[nodiscard]] bool isExperimentSelected(const ExperimentOptions &options, const std::string &name);
+
+struct ExperimentOutcome {
+  /**
+   * The results the experiment recorded, which are only those recorded before it failed if it did.
+   * */
+  std::vector<ResultRecord> records;
+  /**
+   * False if the experiment threw, or if the process which ran it did not exit normally.
+   * */
+  bool succeeded = true;
+};
+
 class ExperimentRunner {
+  std::string experimentName;
   std::function<void()> experimentFunction;
 
+  void printPerformanceCounters(const PerformanceCounters &performanceCounters) const;
+
+  [[nodiscard]] std::vector<ResultRecord> benchmark(const ExperimentOptions &options) const;
+
 public:
-  explicit ExperimentRunner(std::function<void()> function) : experimentFunction(std::move(function)) {}
+  ExperimentRunner(std::string name, std::function<void()> function) : experimentName(std::move(name)), experimentFunction(std::move(function)) {}
 
-  void run() noexcept;
+  [[nodiscard]] const std::string &getName() const noexcept { return experimentName; }
+
+  [[nodiscard]] ExperimentOutcome run(const ExperimentOptions &options) const noexcept;
 };
+
+/**
+ * Returns the options of the experiments being run, which are the default options outside of runExperiments().
+ * */
+[[nodiscard]] const ExperimentOptions &getExperimentOptions() noexcept;
+
+/**
+ * Runs the selected experiments, in forked processes if more than one job was requested, and returns false if any of them failed or, when there is a
+ * baseline, if any of their metrics regressed from it or is missing from their results.
+ *
+ * Throws std::runtime_error if the baseline cannot be read or the results cannot be written.
+ * */
+[[nodiscard]] bool runExperiments(const std::vector<ExperimentRunner> &experimentRunners, const ExperimentOptions &options);
 } // namespace Experiments
@@ -0,0 +1,332 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <utility>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "types.hpp"
+
+namespace Experiments {
+/**
+ * An open addressing hash set which stores its elements inline in a single array of slots, in the style of the Swiss tables.
+ *
+ * Each slot has a control byte which is either empty, deleted, or holds 7 bits of the hash of its element. Probing compares the control bytes of a group of 16
+ * slots at once, so that elements are only compared with the elements whose 7 bits of hash match, which is usually only the element being looked for.
+ * The control bytes of the first group are repeated after the last one, so that a group can be loaded from any slot without wrapping around.
+ *
+ * Erasing leaves a deleted marker behind, so that probes continue past it, and markers are cleared when the set is rehashed.
+ * */
+template <typename T, typename Hash = std::hash<T>, typename KeyEqual = std::equal_to<T>> class FlatHashSet {
+  using Control = signed char;
+
+  static constexpr Control Empty = -128;
+  static constexpr Control Deleted = -2;
+  static constexpr std::size_t GroupWidth = 16;
+  /**
+   * The set grows when more than 7 in 8 of the slots are full or deleted.
+   * */
+  static constexpr std::size_t MaximumLoadNumerator = 7;
+  static constexpr std::size_t MaximumLoadDenominator = 8;
+
+  Control *controls = nullptr;
+  T *slots = nullptr;
+  std::size_t slotCount = 0;
+  std::size_t elementCount = 0;
+  std::size_t deletedCount = 0;
+  [[no_unique_address]] Hash hasher;
+  [[no_unique_address]] KeyEqual keyEqual;
+
+  /**
+   * Bit i is set if the control byte of slot i of the group matches.
+   * */
+  class Group {
+#ifdef __SSE2__
+    __m128i controlBytes;
+#else
+    Control controlBytes[GroupWidth];
+#endif
+
+  public:
+    explicit Group(const Control *const groupControls) {
+#ifdef __SSE2__
+      controlBytes = _mm_loadu_si128(reinterpret_cast<const __m128i *>(groupControls));
+#else
+      std::memcpy(controlBytes, groupControls, GroupWidth);
+#endif
+    }
+
+    [[nodiscard]] U32 match(const Control control) const noexcept {
+#ifdef __SSE2__
+      return static_cast<U32>(_mm_movemask_epi8(_mm_cmpeq_epi8(controlBytes, _mm_set1_epi8(control))));
+#else
+      U32 mask = 0;
+      for (std::size_t i = 0; i < GroupWidth; i++) {
+        mask |= static_cast<U32>(controlBytes[i] == control) << i;
+      }
+      return mask;
+#endif
+    }
+  };
+
+  /**
+   * Standard library hashes of integers are usually the identity, so the hash is mixed to spread its bits to both the slot index and the control byte.
+   * */
+  [[nodiscard]] U64 getMixedHash(const T &key) const {
+    // The finalizer of MurmurHash3, which makes every bit of the result depend on every bit of the hash.
+    auto hash = static_cast<U64>(hasher(key));
+    hash ^= hash >> 33u;
+    hash *= 0xFF51AFD7ED558CCDu;
+    hash ^= hash >> 33u;
+    hash *= 0xC4CEB9FE1A85EC53u;
+    hash ^= hash >> 33u;
+    return hash;
+  }
+
+  [[nodiscard]] static Control getControlOfHash(const U64 hash) noexcept { return static_cast<Control>(hash & 0x7Fu); }
+
+  [[nodiscard]] static std::size_t getMaximumLoad(const std::size_t slots) noexcept { return slots / MaximumLoadDenominator * MaximumLoadNumerator; }
+
+  void setControl(const std::size_t slot, const Control control) noexcept {
+    controls[slot] = control;
+    if (slot < GroupWidth) {
+      controls[slotCount + slot] = control;
+    }
+  }
+
+  /**
+   * Calls the function with the slots of the groups along the probe sequence of the hash, as long as it returns false.
+   *
+   * Groups start at any slot and step by one more group each time, which visits every group as the slot count is a power of two.
+   * */
+  template <typename Function> void probe(const U64 hash, Function function) const {
+    const auto mask = slotCount - 1;
+    auto groupStart = static_cast<std::size_t>(hash >> 7u) & mask;
+    for (std::size_t step = GroupWidth;; step += GroupWidth) {
+      if (function(groupStart, Group(controls + groupStart))) {
+        return;
+      }
+      groupStart = (groupStart + step) & mask;
+    }
+  }
+
+  /**
+   * Returns the index of the slot holding the key, or slotCount if the set does not contain it.
+   * */
+  [[nodiscard]] std::size_t findSlot(const T &key, const U64 hash) const {
+    if (slotCount == 0) {
+      return slotCount;
+    }
+    auto found = slotCount;
+    probe(hash, [&](const std::size_t groupStart, const Group &group) {
+      for (auto matches = group.match(getControlOfHash(hash)); matches != 0; matches &= matches - 1) {
+        const auto slot = (groupStart + static_cast<std::size_t>(std::countr_zero(matches))) & (slotCount - 1);
+        if (keyEqual(slots[slot], key)) {
+          found = slot;
+          return true;
+        }
+      }
+      // An empty slot ends every probe sequence which could contain the key, as insertion would have used it.
+      return group.match(Empty) != 0;
+    });
+    return found;
+  }
+
+  /**
+   * Returns the first empty or deleted slot along the probe sequence of the hash, of which there always is one.
+   * */
+  [[nodiscard]] std::size_t findFreeSlot(const U64 hash) const {
+    std::size_t found = 0;
+    probe(hash, [&](const std::size_t groupStart, const Group &group) {
+      const auto freeSlots = group.match(Empty) | group.match(Deleted);
+      if (freeSlots == 0) {
+        return false;
+      }
+      found = (groupStart + static_cast<std::size_t>(std::countr_zero(freeSlots))) & (slotCount - 1);
+      return true;
+    });
+    return found;
+  }
+
+  void rehash(const std::size_t newSlotCount) {
+    auto oldControls = controls;
+    auto oldSlots = slots;
+    const auto oldSlotCount = slotCount;
+    // Both buffers are allocated before either member changes, so that the set is left intact if an allocation fails.
+    auto *const newControls = new Control[newSlotCount + GroupWidth];
+    T *newSlots = nullptr;
+    try {
+      newSlots = std::allocator<T>().allocate(newSlotCount);
+    } catch (...) {
+      delete[] newControls;
+      throw;
+    }
+    std::memset(newControls, Empty, newSlotCount + GroupWidth);
+    controls = newControls;
+    slots = newSlots;
+    slotCount = newSlotCount;
+    deletedCount = 0;
+    for (std::size_t i = 0; i < oldSlotCount; i++) {
+      if (oldControls[i] >= 0) {
+        const auto hash = getMixedHash(oldSlots[i]);
+        const auto slot = findFreeSlot(hash);
+        std::construct_at(slots + slot, std::move(oldSlots[i]));
+        std::destroy_at(oldSlots + i);
+        setControl(slot, getControlOfHash(hash));
+      }
+    }
+    deallocate(oldControls, oldSlots, oldSlotCount);
+  }
+
+  static void deallocate(Control *const controlsToFree, T *const slotsToFree, const std::size_t slotsToFreeCount) {
+    delete[] controlsToFree;
+    if (slotsToFree != nullptr) {
+      std::allocator<T>().deallocate(slotsToFree, slotsToFreeCount);
+    }
+  }
+
+  /**
+   * Makes room for one more element, reclaiming deleted slots instead of growing if they make up much of the load.
+   * */
+  void prepareInsert() {
+    if (elementCount + deletedCount + 1 <= getMaximumLoad(slotCount)) {
+      return;
+    }
+    if (deletedCount > elementCount) {
+      rehash(slotCount);
+    } else {
+      rehash(slotCount == 0 ? GroupWidth : 2 * slotCount);
+    }
+  }
+
+  void destroyElements() noexcept {
+    for (std::size_t i = 0; i < slotCount; i++) {
+      if (controls[i] >= 0) {
+        std::destroy_at(slots + i);
+      }
+    }
+  }
+
+public:
+  FlatHashSet() = default;
+
+  FlatHashSet(const FlatHashSet &) = delete;
+
+  FlatHashSet(FlatHashSet &&rhs) noexcept
+      : controls(std::exchange(rhs.controls, nullptr)), slots(std::exchange(rhs.slots, nullptr)), slotCount(std::exchange(rhs.slotCount, 0)),
+        elementCount(std::exchange(rhs.elementCount, 0)), deletedCount(std::exchange(rhs.deletedCount, 0)), hasher(rhs.hasher), keyEqual(rhs.keyEqual) {}
+
+  FlatHashSet &operator=(const FlatHashSet &) = delete;
+
+  FlatHashSet &operator=(FlatHashSet &&rhs) noexcept {
+    if (this != &rhs) {
+      destroyElements();
+      deallocate(controls, slots, slotCount);
+      controls = std::exchange(rhs.controls, nullptr);
+      slots = std::exchange(rhs.slots, nullptr);
+      slotCount = std::exchange(rhs.slotCount, 0);
+      elementCount = std::exchange(rhs.elementCount, 0);
+      deletedCount = std::exchange(rhs.deletedCount, 0);
+      hasher = rhs.hasher;
+      keyEqual = rhs.keyEqual;
+    }
+    return *this;
+  }
+
+  [[nodiscard]] std::size_t size() const noexcept { return elementCount; }
+
+  [[nodiscard]] bool empty() const noexcept { return elementCount == 0; }
+
+  /**
+   * Returns the number of slots, which is zero or a power of two of at least the group width.
+   * */
+  [[nodiscard]] std::size_t capacity() const noexcept { return slotCount; }
+
+  [[nodiscard]] static constexpr double maxLoadFactor() noexcept {
+    return static_cast<double>(MaximumLoadNumerator) / static_cast<double>(MaximumLoadDenominator);
+  }
+
+  /**
+   * Grows so that the given number of elements fits without rehashing.
+   * */
+  void reserve(const std::size_t count) {
+    auto newSlotCount = slotCount == 0 ? GroupWidth : slotCount;
+    while (getMaximumLoad(newSlotCount) < count) {
+      newSlotCount *= 2;
+    }
+    if (newSlotCount != slotCount) {
+      rehash(newSlotCount);
+    }
+  }
+
+  [[nodiscard]] bool contains(const T &key) const { return findSlot(key, getMixedHash(key)) != slotCount; }
+
+  /**
+   * Returns whether the key was inserted, which it is not if the set already contains it.
+   * */
+  template <typename Key> bool insert(Key &&key) {
+    const auto hash = getMixedHash(key);
+    if (findSlot(key, hash) != slotCount) {
+      return false;
+    }
+    prepareInsert();
+    const auto slot = findFreeSlot(hash);
+    std::construct_at(slots + slot, std::forward<Key>(key));
+    if (controls[slot] == Deleted) {
+      deletedCount--;
+    }
+    setControl(slot, getControlOfHash(hash));
+    elementCount++;
+    return true;
+  }
+
+  /**
+   * Returns whether the key was erased, which it is not if the set does not contain it.
+   * */
+  bool erase(const T &key) {
+    const auto slot = findSlot(key, getMixedHash(key));
+    if (slot == slotCount) {
+      return false;
+    }
+    std::destroy_at(slots + slot);
+    setControl(slot, Deleted);
+    elementCount--;
+    deletedCount++;
+    return true;
+  }
+
+  /**
+   * Destroys the elements but keeps the slots.
+   * */
+  void clear() noexcept {
+    destroyElements();
+    if (controls != nullptr) {
+      std::memset(controls, Empty, slotCount + GroupWidth);
+    }
+    elementCount = 0;
+    deletedCount = 0;
+  }
+
+  /**
+   * Calls the function with each element, in no particular order.
+   * */
+  template <typename Function> void forEach(Function function) const {
+    for (std::size_t i = 0; i < slotCount; i++) {
+      if (controls[i] >= 0) {
+        function(slots[i]);
+      }
+    }
+  }
+
+  ~FlatHashSet() {
+    destroyElements();
+    deallocate(controls, slots, slotCount);
+  }
+};
+} // namespace Experiments
@@ -1,8 +1,9 @@
 #include "formatting.hpp"
 
-#include <iomanip>
-#include <sstream>
+#include <array>
+#include <charconv>
 #include <string>
+#include <system_error>
 #include <vector>
 
 #include "types.hpp"
@@ -27,10 +28,22 @@ std::string enumerate(const std::vector<std::string> &strings) {
   return result;
 }
 
-std::string toFixedPrecisionString(double value, U32 decimalPlaces) {
-  std::stringstream stream;
-  stream << std::fixed << std::setprecision(static_cast<int>(decimalPlaces)) << value;
-  return stream.str();
+std::to_chars_result toCharsWithFixedPrecision(char *const first, char *const last, const double value, const U32 decimalPlaces) noexcept {
+  return std::to_chars(first, last, value, std::chars_format::fixed, static_cast<int>(decimalPlaces));
+}
+
+std::string toFixedPrecisionString(const double value, const U32 decimalPlaces) {
+  // Enough for the values this project prints, and the largest doubles have over 300 digits before the point, so longer strings are written in place.
+  std::array<char, 64> buffer{};
+  const auto [end, error] = toCharsWithFixedPrecision(buffer.data(), buffer.data() + buffer.size(), value, decimalPlaces);
+  if (error == std::errc()) {
+    return {buffer.data(), end};
+  }
+  static constexpr std::size_t MaximumDigitsBeforePoint = 310;
+  std::string string(MaximumDigitsBeforePoint + 2 + decimalPlaces, '\0');
+  const auto result = toCharsWithFixedPrecision(string.data(), string.data() + string.size(), value, decimalPlaces);
+  string.resize(static_cast<std::size_t>(result.ptr - string.data()));
+  return string;
 }
 
 std::string pluralizeAsNeeded(const U64 value, const std::string_view noun) {
@@ -43,16 +56,58 @@ std::string pluralizeAsNeeded(const U64 value, const std::string_view noun) {
   return result;
 }
 
-class WithThousandsSeparators : public std::numpunct<char> {
-protected:
-  char do_thousands_sep() const override { return ','; }
-  std::string do_grouping() const override { return "\03"; }
-};
+std::to_chars_result toCharsWithThousandsSeparators(char *const first, char *const last, const U64 value) noexcept {
+  std::array<char, 20> digits{};
+  const auto digitsEnd = std::to_chars(digits.data(), digits.data() + digits.size(), value).ptr;
+  const auto digitCount = static_cast<std::size_t>(digitsEnd - digits.data());
+  const auto length = digitCount + (digitCount - 1) / 3;
+  if (static_cast<std::size_t>(last - first) < length) {
+    return {last, std::errc::value_too_large};
+  }
+  auto *output = first;
+  for (std::size_t i = 0; i < digitCount; i++) {
+    if (i > 0 && (digitCount - i) % 3 == 0) {
+      *output++ = ',';
+    }
+    *output++ = digits[i];
+  }
+  return {output, std::errc()};
+}
+
+std::string toStringWithThousandsSeparators(const U64 value) {
+  std::array<char, MaximumThousandsSeparatedLength> buffer{};
+  return {buffer.data(), toCharsWithThousandsSeparators(buffer.data(), buffer.data() + buffer.size(), value).ptr};
+}
 
-[[nodiscard]] std::string toStringWithThousandsSeparators(U64 value) {
-  std::stringstream stream;
-  stream.imbue(std::locale(std::locale::classic(), new WithThousandsSeparators));
-  stream << value;
-  return stream.str();
+std::string toDurationString(const double seconds) {
+  static constexpr U32 DurationDecimalPlaces = 3;
+  if (seconds >= 1.0) {
+    return toFixedPrecisionString(seconds, DurationDecimalPlaces) + " s";
+  }
+  if (seconds >= 1e-3) {
+    return toFixedPrecisionString(seconds * 1e3, DurationDecimalPlaces) + " ms";
+  }
+  if (seconds >= 1e-6) {
+    return toFixedPrecisionString(seconds * 1e6, DurationDecimalPlaces) + " us";
+  }
+  return toFixedPrecisionString(seconds * 1e9, DurationDecimalPlaces) + " ns";
+}
+
+std::string toByteSizeString(const U64 bytes) {
+  static constexpr U32 ByteSizeDecimalPlaces = 1;
+  static constexpr std::array<std::string_view, 4> Units{"KiB", "MiB", "GiB", "TiB"};
+  if (bytes < 1024) {
+    return pluralizeAsNeeded(bytes, "byte");
+  }
+  std::size_t unit = 0;
+  U64 unitSize = 1024;
+  while (unit + 1 < Units.size() && bytes >= unitSize * 1024) {
+    unit++;
+    unitSize *= 1024;
+  }
+  if (bytes % unitSize == 0) {
+    return std::to_string(bytes / unitSize) + " " + std::string(Units[unit]);
+  }
+  return toFixedPrecisionString(static_cast<double>(bytes) / static_cast<double>(unitSize), ByteSizeDecimalPlaces) + " " + std::string(Units[unit]);
 }
 } // namespace Experiments
\ No newline at end of file
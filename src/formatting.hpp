@@ -1,5 +1,7 @@
 #pragma once
 
+#include <charconv>
+#include <cstddef>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -23,9 +25,36 @@ template <typename T> std::string getPrettyTypeName() {
 
 [[nodiscard]] std::string enumerate(const std::vector<std::string> &strings);
 
+/**
+ * The most characters toCharsWithThousandsSeparators writes, which are the 20 digits of the largest U64 and 6 separators.
+ * */
+static constexpr std::size_t MaximumThousandsSeparatedLength = 26;
+
+/**
+ * Writes the value with a comma between every group of three digits into [first, last) like std::to_chars, without allocating.
+ *
+ * If the buffer is too small, returns last and std::errc::value_too_large and leaves the contents of the buffer unspecified.
+ * */
+[[nodiscard]] std::to_chars_result toCharsWithThousandsSeparators(char *first, char *last, U64 value) noexcept;
+
+/**
+ * Writes the value with the given number of decimal places and no exponent into [first, last) like std::to_chars, without allocating.
+ * */
+[[nodiscard]] std::to_chars_result toCharsWithFixedPrecision(char *first, char *last, double value, unsigned decimalPlaces) noexcept;
+
 [[nodiscard]] std::string toFixedPrecisionString(double value, unsigned decimalPlaces);
 
 [[nodiscard]] std::string pluralizeAsNeeded(U64 value, std::string_view noun);
 
 [[nodiscard]] std::string toStringWithThousandsSeparators(U64 value);
+
+/**
+ * Formats a duration in seconds with the largest unit, from nanoseconds to seconds, in which it is at least one.
+ * */
+[[nodiscard]] std::string toDurationString(double seconds);
+
+/**
+ * Formats a size in bytes with the largest binary unit, from bytes to TiB, in which it is at least one, with decimals only if it is not a whole number of them.
+ * */
+[[nodiscard]] std::string toByteSizeString(U64 bytes);
 } // namespace Experiments
@@ -0,0 +1,242 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace Experiments {
+enum class GrowthRelocation {
+  /**
+   * Allocates a new buffer with operator new, moves the elements into it and frees the old one, as std::vector does.
+   * */
+  AllocateAndMove,
+  /**
+   * Grows the buffer with realloc, which extends it in place when the memory after it is free and only then avoids copying.
+   * */
+  Realloc,
+  /**
+   * Maps the buffer with mmap and grows it with mremap, which moves page table entries instead of copying when the buffer cannot be extended in place.
+   * Buffers are whole pages, so small vectors waste most of a page.
+   * */
+  Mremap
+};
+
+struct GrowthStatistics {
+  std::size_t relocations = 0;
+  /**
+   * The number of relocations after which the elements were at a different address.
+   * */
+  std::size_t movedRelocations = 0;
+  /**
+   * The bytes the vector copied itself, which excludes any copying done inside realloc.
+   * */
+  std::size_t bytesCopied = 0;
+  /**
+   * The largest number of bytes held at once, counting both buffers while relocating by allocating and moving.
+   * */
+  std::size_t peakReservedBytes = 0;
+};
+
+/**
+ * A vector which grows its capacity by a configurable factor, and which can relocate its elements through realloc or mremap if they are trivially copyable.
+ * */
+template <typename T, GrowthRelocation Relocation = GrowthRelocation::AllocateAndMove> class GrowthVector {
+  static_assert(Relocation == GrowthRelocation::AllocateAndMove || std::is_trivially_copyable_v<T>,
+                "Only trivially copyable elements can be relocated by realloc or mremap.");
+
+  T *elements = nullptr;
+  std::size_t elementCount = 0;
+  std::size_t elementCapacity = 0;
+  double factor;
+  GrowthStatistics statistics;
+
+  [[nodiscard]] static std::size_t getPageSize() noexcept {
+    static const auto pageSize = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+    return pageSize;
+  }
+
+  /**
+   * The largest capacity whose size in bytes, even rounded up to whole pages, fits in a std::size_t, which is also the largest std::allocator accepts.
+   * */
+  [[nodiscard]] static constexpr std::size_t getMaximumCapacity() noexcept { return std::numeric_limits<std::ptrdiff_t>::max() / sizeof(T); }
+
+  [[nodiscard]] std::size_t getGrownCapacity() const noexcept {
+    const auto grownCapacity = std::ceil(static_cast<double>(elementCapacity) * factor);
+    if (grownCapacity >= static_cast<double>(getMaximumCapacity())) {
+      return std::max(elementCapacity + 1, getMaximumCapacity());
+    }
+    return std::max(elementCapacity + 1, static_cast<std::size_t>(grownCapacity));
+  }
+
+  /**
+   * Relocates the elements into a buffer of the new capacity and, if ConstructsElement is set, constructs an element from the arguments after them, which
+   * is only supported when allocating and moving.
+   *
+   * The arguments may refer to an element, so the new element is constructed in the new buffer before the elements are moved out of the old one.
+   * */
+  template <bool ConstructsElement = false, typename... Arguments> void relocate(std::size_t newCapacity, Arguments &&...arguments) {
+    static_assert(!ConstructsElement || Relocation == GrowthRelocation::AllocateAndMove, "Only allocating and moving constructs the new element.");
+    if (newCapacity > getMaximumCapacity()) {
+      throw std::bad_alloc();
+    }
+    auto *newElements = elements;
+    if constexpr (Relocation == GrowthRelocation::AllocateAndMove) {
+      newElements = std::allocator<T>().allocate(newCapacity);
+      std::size_t constructedCount = 0;
+      try {
+        if constexpr (ConstructsElement) {
+          std::construct_at(newElements + elementCount, std::forward<Arguments>(arguments)...);
+          constructedCount = 1;
+        }
+        std::uninitialized_move(elements, elements + elementCount, newElements);
+      } catch (...) {
+        std::destroy_n(newElements + elementCount, constructedCount);
+        std::allocator<T>().deallocate(newElements, newCapacity);
+        throw;
+      }
+      std::destroy(elements, elements + elementCount);
+      statistics.bytesCopied += elementCount * sizeof(T);
+      statistics.peakReservedBytes = std::max(statistics.peakReservedBytes, (elementCapacity + newCapacity) * sizeof(T));
+      if (elements != nullptr) {
+        std::allocator<T>().deallocate(elements, elementCapacity);
+      }
+    } else if constexpr (Relocation == GrowthRelocation::Realloc) {
+      newElements = static_cast<T *>(std::realloc(elements, newCapacity * sizeof(T)));
+      if (newElements == nullptr) {
+        throw std::bad_alloc();
+      }
+    } else {
+      // Every byte of the mapped pages is usable, so the capacity is rounded up to fill them.
+      const auto newBytes = (newCapacity * sizeof(T) + getPageSize() - 1) / getPageSize() * getPageSize();
+      newCapacity = newBytes / sizeof(T);
+      void *mapping = MAP_FAILED;
+      if (elements == nullptr) {
+        mapping = mmap(nullptr, newBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      } else {
+        mapping = mremap(elements, getMappedBytes(), newBytes, MREMAP_MAYMOVE);
+      }
+      if (mapping == MAP_FAILED) {
+        throw std::bad_alloc();
+      }
+      newElements = static_cast<T *>(mapping);
+    }
+    if constexpr (Relocation != GrowthRelocation::AllocateAndMove) {
+      statistics.peakReservedBytes = std::max(statistics.peakReservedBytes, newCapacity * sizeof(T));
+    }
+    statistics.relocations++;
+    if (elements != nullptr && newElements != elements) {
+      statistics.movedRelocations++;
+    }
+    elements = newElements;
+    elementCapacity = newCapacity;
+  }
+
+  [[nodiscard]] std::size_t getMappedBytes() const noexcept { return (elementCapacity * sizeof(T) + getPageSize() - 1) / getPageSize() * getPageSize(); }
+
+  void release() noexcept {
+    std::destroy(elements, elements + elementCount);
+    if (elements == nullptr) {
+      return;
+    }
+    if constexpr (Relocation == GrowthRelocation::AllocateAndMove) {
+      std::allocator<T>().deallocate(elements, elementCapacity);
+    } else if constexpr (Relocation == GrowthRelocation::Realloc) {
+      std::free(elements);
+    } else {
+      munmap(elements, getMappedBytes());
+    }
+  }
+
+public:
+  /**
+   * Throws std::invalid_argument if the growth factor is not greater than one.
+   * */
+  explicit GrowthVector(const double growthFactor = 2.0) : factor(growthFactor) {
+    if (!(growthFactor > 1.0)) {
+      throw std::invalid_argument("The growth factor must be greater than one.");
+    }
+  }
+
+  GrowthVector(const GrowthVector &) = delete;
+
+  GrowthVector(GrowthVector &&rhs) noexcept
+      : elements(std::exchange(rhs.elements, nullptr)), elementCount(std::exchange(rhs.elementCount, 0)),
+        elementCapacity(std::exchange(rhs.elementCapacity, 0)), factor(rhs.factor), statistics(std::exchange(rhs.statistics, {})) {}
+
+  GrowthVector &operator=(const GrowthVector &) = delete;
+
+  GrowthVector &operator=(GrowthVector &&rhs) noexcept {
+    if (this != &rhs) {
+      release();
+      elements = std::exchange(rhs.elements, nullptr);
+      elementCount = std::exchange(rhs.elementCount, 0);
+      elementCapacity = std::exchange(rhs.elementCapacity, 0);
+      factor = rhs.factor;
+      statistics = std::exchange(rhs.statistics, {});
+    }
+    return *this;
+  }
+
+  template <typename... Arguments> T &emplace_back(Arguments &&...arguments) {
+    if (elementCount == elementCapacity) [[unlikely]] {
+      if constexpr (Relocation == GrowthRelocation::AllocateAndMove) {
+        relocate<true>(getGrownCapacity(), std::forward<Arguments>(arguments)...);
+        return elements[elementCount++];
+      } else {
+        // realloc and mremap release the old buffer themselves, so the arguments are read before, into a copy which is cheap as T is trivially copyable.
+        const T element(std::forward<Arguments>(arguments)...);
+        relocate(getGrownCapacity());
+        return *std::construct_at(elements + elementCount++, element);
+      }
+    }
+    return *std::construct_at(elements + elementCount++, std::forward<Arguments>(arguments)...);
+  }
+
+  void push_back(const T &element) { emplace_back(element); }
+
+  void push_back(T &&element) { emplace_back(std::move(element)); }
+
+  void reserve(const std::size_t capacity) {
+    if (capacity > elementCapacity) {
+      relocate(capacity);
+    }
+  }
+
+  [[nodiscard]] T &operator[](const std::size_t index) noexcept { return elements[index]; }
+
+  [[nodiscard]] const T &operator[](const std::size_t index) const noexcept { return elements[index]; }
+
+  [[nodiscard]] T *data() noexcept { return elements; }
+
+  [[nodiscard]] const T *data() const noexcept { return elements; }
+
+  [[nodiscard]] T *begin() noexcept { return elements; }
+
+  [[nodiscard]] T *end() noexcept { return elements + elementCount; }
+
+  [[nodiscard]] const T *begin() const noexcept { return elements; }
+
+  [[nodiscard]] const T *end() const noexcept { return elements + elementCount; }
+
+  [[nodiscard]] std::size_t size() const noexcept { return elementCount; }
+
+  [[nodiscard]] std::size_t capacity() const noexcept { return elementCapacity; }
+
+  [[nodiscard]] double growthFactor() const noexcept { return factor; }
+
+  [[nodiscard]] const GrowthStatistics &getStatistics() const noexcept { return statistics; }
+
+  ~GrowthVector() { release(); }
+};
+} // namespace Experiments
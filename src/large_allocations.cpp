@@ -0,0 +1,204 @@
+#include "large_allocations.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+
+#include "experiment_runner.hpp"
+#include "formatting.hpp"
+#include "results.hpp"
+#include "system_memory.hpp"
+#include "timing.hpp"
+#include "types.hpp"
+
+namespace Experiments {
+/**
+ * Each strategy allocates this many buffers, one after another, as a single allocation is too noisy to compare.
+ * */
+static constexpr std::size_t LargeAllocationRounds = 3;
+
+namespace {
+struct LargeAllocationStrategy {
+  std::string_view name;
+  bool requestsHugePages;
+  /**
+   * Allocates the given number of bytes, which are freed or unmapped with the last copy of the pointer.
+   * */
+  std::function<std::shared_ptr<U8>(std::size_t size)> allocate;
+};
+
+struct LargeAllocationMeasurement {
+  double allocationSeconds = 0.0;
+  double firstTouchSeconds = 0.0;
+  double pageFaults = 0.0;
+  double sequentialScanSeconds = 0.0;
+  double randomScanSeconds = 0.0;
+  double hugePageFraction = 0.0;
+};
+} // namespace
+
+static std::function<std::shared_ptr<U8>(std::size_t size)> makeMappedAllocation(const HugePageAdvice advice, const PagePopulation population) {
+  return [advice, population](const std::size_t size) {
+    const auto memory = std::make_shared<MappedMemory>(size, advice, population);
+    return std::shared_ptr<U8>(memory, memory->data());
+  };
+}
+
+static std::vector<LargeAllocationStrategy> makeLargeAllocationStrategies() {
+  return {
+      {"std::malloc", false,
+       [](const std::size_t size) {
+         auto *const data = static_cast<U8 *>(std::malloc(size));
+         if (data == nullptr) {
+           throw std::bad_alloc();
+         }
+         return std::shared_ptr<U8>(data, [](U8 *const pointer) { std::free(pointer); });
+       }},
+      {"mmap", false, makeMappedAllocation(HugePageAdvice::None, PagePopulation::OnFirstTouch)},
+      {"mmap, MAP_POPULATE", false, makeMappedAllocation(HugePageAdvice::None, PagePopulation::MapPopulate)},
+      {"mmap, MADV_HUGEPAGE", true, makeMappedAllocation(HugePageAdvice::Enabled, PagePopulation::OnFirstTouch)},
+      {"mmap, MADV_HUGEPAGE, MADV_POPULATE_WRITE", true, makeMappedAllocation(HugePageAdvice::Enabled, PagePopulation::PopulateWrite)},
+  };
+}
+
+[[nodiscard]] static U64 sumSequentially(const U8 *const data, const std::size_t size) noexcept {
+  const auto *const words = reinterpret_cast<const U64 *>(data);
+  U64 sum = 0;
+  for (std::size_t i = 0; i < size / sizeof(U64); i++) {
+    sum += words[i];
+  }
+  return sum;
+}
+
+/**
+ * Reads about one word per cache line of the buffer, at random, with reads which do not depend on each other so that their misses overlap.
+ * */
+[[nodiscard]] static U64 sumRandomly(const U8 *const data, const std::size_t size) noexcept {
+  static constexpr std::size_t BytesPerRead = 64;
+  const auto *const words = reinterpret_cast<const U64 *>(data);
+  const auto wordCount = size / sizeof(U64);
+  U64 state = 0x9E3779B97F4A7C15;
+  U64 sum = 0;
+  for (std::size_t i = 0; i < size / BytesPerRead; i++) {
+    // A xorshift generator is cheap enough not to hide the cost of the reads.
+    state ^= state << 13u;
+    state ^= state >> 7u;
+    state ^= state << 17u;
+    sum += words[state % wordCount];
+  }
+  return sum;
+}
+
+[[nodiscard]] static LargeAllocationMeasurement measureLargeAllocation(const LargeAllocationStrategy &strategy, const std::size_t size) {
+  const auto pageSize = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+  LargeAllocationMeasurement measurement;
+  const auto minorPageFaultsAtStart = getMinorPageFaults();
+  std::shared_ptr<U8> data;
+  measurement.allocationSeconds = measureRepeatedly(1, []() {}, [&data, &strategy, size]() { data = strategy.allocate(size); }).median;
+  measurement.firstTouchSeconds = measureRepeatedly(1, []() {},
+                                                    [&data, size, pageSize]() {
+                                                      for (std::size_t i = 0; i < size; i += pageSize) {
+                                                        data.get()[i] = 1;
+                                                      }
+                                                      preventOptimization(data);
+                                                    })
+                                      .median;
+  measurement.pageFaults = static_cast<double>(getMinorPageFaults() - minorPageFaultsAtStart);
+  U64 sum = 0;
+  measurement.sequentialScanSeconds = measureRepeatedly(1, []() {}, [&data, &sum, size]() { sum += sumSequentially(data.get(), size); }).median;
+  measurement.randomScanSeconds = measureRepeatedly(1, []() {}, [&data, &sum, size]() { sum += sumRandomly(data.get(), size); }).median;
+  preventOptimization(sum);
+  measurement.hugePageFraction = static_cast<double>(getHugePageBackedSize(data.get(), size)) / static_cast<double>(size);
+  return measurement;
+}
+
+/**
+ * Measures the strategy several times, each time with a new buffer, and returns the median of each measurement.
+ * */
+[[nodiscard]] static LargeAllocationMeasurement measureLargeAllocationRepeatedly(const LargeAllocationStrategy &strategy, const std::size_t size) {
+  std::vector<LargeAllocationMeasurement> measurements;
+  for (std::size_t round = 0; round < LargeAllocationRounds; round++) {
+    measurements.push_back(measureLargeAllocation(strategy, size));
+  }
+  const auto getMedian = [&measurements](double LargeAllocationMeasurement::*const field) {
+    std::vector<double> values;
+    for (const auto &measurement : measurements) {
+      values.push_back(measurement.*field);
+    }
+    return computeTimingStatistics(std::move(values)).median;
+  };
+  LargeAllocationMeasurement median;
+  median.allocationSeconds = getMedian(&LargeAllocationMeasurement::allocationSeconds);
+  median.firstTouchSeconds = getMedian(&LargeAllocationMeasurement::firstTouchSeconds);
+  median.pageFaults = getMedian(&LargeAllocationMeasurement::pageFaults);
+  median.sequentialScanSeconds = getMedian(&LargeAllocationMeasurement::sequentialScanSeconds);
+  median.randomScanSeconds = getMedian(&LargeAllocationMeasurement::randomScanSeconds);
+  median.hugePageFraction = getMedian(&LargeAllocationMeasurement::hugePageFraction);
+  return median;
+}
+
+void testLargeAllocations() {
+  static constexpr int NameWidth = 42;
+  static constexpr int ColumnWidth = 16;
+  const auto size = getExperimentOptions().maximumWorkingSetSize;
+  const auto transparentHugePageMode = getTransparentHugePageMode();
+  const auto hugePagesAvailable = !transparentHugePageMode.empty() && transparentHugePageMode != "never";
+  std::cout << "Testing allocating a " << toByteSizeString(size) << " buffer, touching every page of it once and then scanning it, at the median of "
+            << pluralizeAsNeeded(LargeAllocationRounds, "buffer") << ".\n";
+  if (hugePagesAvailable) {
+    std::cout << Indentation << "Transparent huge pages are set to " << transparentHugePageMode << ".\n";
+  } else {
+    std::cout << Indentation << "Transparent huge pages are not available, so the strategies which request them are skipped.\n";
+  }
+  std::cout << Indentation << std::setw(NameWidth) << "";
+  for (const auto *const column : {"Allocate", "First touch", "Page faults", "Sequential scan", "Random scan", "Huge pages"}) {
+    std::cout << std::setw(ColumnWidth) << column;
+  }
+  std::cout << "\n";
+  std::optional<std::pair<std::string_view, double>> fastestStartup;
+  for (const auto &strategy : makeLargeAllocationStrategies()) {
+    if (strategy.requestsHugePages && !hugePagesAvailable) {
+      continue;
+    }
+    std::cout << Indentation << std::setw(NameWidth) << std::left << strategy.name << std::right;
+    LargeAllocationMeasurement measurement;
+    try {
+      measurement = measureLargeAllocationRepeatedly(strategy, size);
+    } catch (const std::system_error &error) {
+      std::cout << error.what() << "\n";
+      continue;
+    }
+    std::cout << std::setw(ColumnWidth) << toDurationString(measurement.allocationSeconds) << std::setw(ColumnWidth)
+              << toDurationString(measurement.firstTouchSeconds) << std::setw(ColumnWidth)
+              << toStringWithThousandsSeparators(static_cast<U64>(measurement.pageFaults)) << std::setw(ColumnWidth)
+              << toDurationString(measurement.sequentialScanSeconds) << std::setw(ColumnWidth) << toDurationString(measurement.randomScanSeconds)
+              << std::setw(ColumnWidth - 1) << toFixedPrecisionString(measurement.hugePageFraction * 100.0, 0) << "%\n";
+    const auto startupSeconds = measurement.allocationSeconds + measurement.firstTouchSeconds;
+    if (!fastestStartup || startupSeconds < fastestStartup->second) {
+      fastestStartup.emplace(strategy.name, startupSeconds);
+    }
+    const auto metric = std::string(strategy.name) + " of " + toByteSizeString(size);
+    recordResult(metric + ", allocation and first touch", startupSeconds, "s");
+    recordResult(metric + ", page faults", measurement.pageFaults, "faults");
+    recordResult(metric + ", sequential scan", measurement.sequentialScanSeconds, "s");
+    recordResult(metric + ", random scan", measurement.randomScanSeconds, "s");
+  }
+  if (fastestStartup) {
+    std::cout << Indentation << "Allocating and touching every page took the least time with " << fastestStartup->first << ", "
+              << toDurationString(fastestStartup->second) << ".\n";
+  }
+}
+} // namespace Experiments
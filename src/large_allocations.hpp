@@ -0,0 +1,10 @@
+#pragma once
+
+namespace Experiments {
+/**
+ * Compares allocating a buffer of the maximum working set with std::malloc, with mmap, with mmap and MAP_POPULATE, and with mmap and MADV_HUGEPAGE, with
+ * and without MADV_POPULATE_WRITE, reporting the time to allocate it and to first touch every page, the minor page faults this took, the time of a
+ * sequential and of a random scan, and how much of it huge pages backed.
+ * */
+void testLargeAllocations();
+} // namespace Experiments
@@ -0,0 +1,194 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+namespace Experiments {
+template <typename... Types> struct TypeList {};
+
+/**
+ * Aggregates with up to this many fields can be analyzed.
+ * */
+static constexpr std::size_t MaximumAnalyzedFieldCount = 16;
+
+namespace LayoutAnalysis {
+/**
+ * Converts to the type of any field, so that a list of them shows how many fields an aggregate can be initialized with.
+ * */
+struct AnyField {
+  template <typename T> constexpr operator T() const noexcept;
+};
+
+template <typename T, std::size_t... Indices> constexpr bool isInitializableWith(std::index_sequence<Indices...>) noexcept {
+  return requires { T{(static_cast<void>(Indices), AnyField{})...}; };
+}
+
+template <typename T, std::size_t Count = 0> constexpr std::size_t countFields() noexcept {
+  if constexpr (Count < MaximumAnalyzedFieldCount && isInitializableWith<T>(std::make_index_sequence<Count + 1>())) {
+    return countFields<T, Count + 1>();
+  } else {
+    return Count;
+  }
+}
+
+/**
+ * Only named in unevaluated operands, so the structured binding never binds to an object.
+ * */
+template <typename T, std::size_t FieldCount> auto getFieldTypes(T &value) {
+  if constexpr (FieldCount == 0) {
+    static_cast<void>(value);
+    return TypeList<>{};
+  } else if constexpr (FieldCount == 1) {
+    auto &[f0] = value;
+    return TypeList<decltype(f0)>{};
+  } else if constexpr (FieldCount == 2) {
+    auto &[f0, f1] = value;
+    return TypeList<decltype(f0), decltype(f1)>{};
+  } else if constexpr (FieldCount == 3) {
+    auto &[f0, f1, f2] = value;
+    return TypeList<decltype(f0), decltype(f1), decltype(f2)>{};
+  } else if constexpr (FieldCount == 4) {
+    auto &[f0, f1, f2, f3] = value;
+    return TypeList<decltype(f0), decltype(f1), decltype(f2), decltype(f3)>{};
+  } else if constexpr (FieldCount == 5) {
+    auto &[f0, f1, f2, f3, f4] = value;
+    return TypeList<decltype(f0), decltype(f1), decltype(f2), decltype(f3), decltype(f4)>{};
+  } else if constexpr (FieldCount == 6) {
+    auto &[f0, f1, f2, f3, f4, f5] = value;
+    return TypeList<decltype(f0), decltype(f1), decltype(f2), decltype(f3), decltype(f4), decltype(f5)>{};
+  } else if constexpr (FieldCount == 7) {
+    auto &[f0, f1, f2, f3, f4, f5, f6] = value;
+    return TypeList<decltype(f0), decltype(f1), decltype(f2), decltype(f3), decltype(f4), decltype(f5), decltype(f6)>{};
+  } else if constexpr (FieldCount == 8) {
+    auto &[f0, f1, f2, f3, f4, f5, f6, f7] = value;
+    return TypeList<decltype(f0), decltype(f1), decltype(f2), decltype(f3), decltype(f4), decltype(f5), decltype(f6), decltype(f7)>{};
+  } else if constexpr (FieldCount == 9) {
+    auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8] = value;
+    return TypeList<decltype(f0), decltype(f1), decltype(f2), decltype(f3), decltype(f4), decltype(f5), decltype(f6), decltype(f7), decltype(f8)>{};
+  } else if constexpr (FieldCount == 10) {
+    auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8, f9] = value;
+    return TypeList<decltype(f0), decltype(f1), decltype(f2), decltype(f3), decltype(f4), decltype(f5), decltype(f6), decltype(f7), decltype(f8),
+                    decltype(f9)>{};
+  } else if constexpr (FieldCount == 11) {
+    auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10] = value;
+    return TypeList<decltype(f0), decltype(f1), decltype(f2), decltype(f3), decltype(f4), decltype(f5), decltype(f6), decltype(f7), decltype(f8), decltype(f9),
+                    decltype(f10)>{};
+  } else if constexpr (FieldCount == 12) {
+    auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11] = value;
+    return TypeList<decltype(f0), decltype(f1), decltype(f2), decltype(f3), decltype(f4), decltype(f5), decltype(f6), decltype(f7), decltype(f8), decltype(f9),
+                    decltype(f10), decltype(f11)>{};
+  } else if constexpr (FieldCount == 13) {
+    auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12] = value;
+    return TypeList<decltype(f0), decltype(f1), decltype(f2), decltype(f3), decltype(f4), decltype(f5), decltype(f6), decltype(f7), decltype(f8), decltype(f9),
+                    decltype(f10), decltype(f11), decltype(f12)>{};
+  } else if constexpr (FieldCount == 14) {
+    auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13] = value;
+    return TypeList<decltype(f0), decltype(f1), decltype(f2), decltype(f3), decltype(f4), decltype(f5), decltype(f6), decltype(f7), decltype(f8), decltype(f9),
+                    decltype(f10), decltype(f11), decltype(f12), decltype(f13)>{};
+  } else if constexpr (FieldCount == 15) {
+    auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14] = value;
+    return TypeList<decltype(f0), decltype(f1), decltype(f2), decltype(f3), decltype(f4), decltype(f5), decltype(f6), decltype(f7), decltype(f8), decltype(f9),
+                    decltype(f10), decltype(f11), decltype(f12), decltype(f13), decltype(f14)>{};
+  } else if constexpr (FieldCount == 16) {
+    auto &[f0, f1, f2, f3, f4, f5, f6, f7, f8, f9, f10, f11, f12, f13, f14, f15] = value;
+    return TypeList<decltype(f0), decltype(f1), decltype(f2), decltype(f3), decltype(f4), decltype(f5), decltype(f6), decltype(f7), decltype(f8), decltype(f9),
+                    decltype(f10), decltype(f11), decltype(f12), decltype(f13), decltype(f14), decltype(f15)>{};
+  }
+}
+
+constexpr std::size_t alignUp(const std::size_t offset, const std::size_t alignment) noexcept { return (offset + alignment - 1) / alignment * alignment; }
+} // namespace LayoutAnalysis
+
+/**
+ * Returns the number of fields of an aggregate, counting the fields of its bases as none.
+ * */
+template <typename T> constexpr std::size_t getFieldCount() noexcept {
+  static_assert(std::is_aggregate_v<T>, "Only the layout of aggregates can be analyzed.");
+  return LayoutAnalysis::countFields<T>();
+}
+
+template <typename T> using FieldTypes = decltype(LayoutAnalysis::getFieldTypes<T, getFieldCount<T>()>(std::declval<T &>()));
+
+struct FieldLayout {
+  std::size_t offset = 0;
+  std::size_t size = 0;
+  std::size_t alignment = 0;
+  /**
+   * The padding between the end of the previous field and this one.
+   * */
+  std::size_t paddingBefore = 0;
+};
+
+template <std::size_t FieldCount> struct LayoutReport {
+  std::array<FieldLayout, FieldCount> fields{};
+  std::size_t size = 0;
+  std::size_t alignment = 1;
+  /**
+   * The padding between the fields and after the last one.
+   * */
+  std::size_t paddingBytes = 0;
+  std::size_t trailingPadding = 0;
+  /**
+   * The size with the fields ordered by decreasing alignment, which leaves no padding between them and is the smallest size of any ordering.
+   * */
+  std::size_t optimalSize = 0;
+  /**
+   * Whether the layout computed from the fields has the size and alignment of the type, which it does not if a field is declared alignas or
+   * [[no_unique_address]], or if the type has bases with fields.
+   * */
+  bool matchesCompiler = false;
+};
+
+/**
+ * Lays the fields out one after another, each at the next offset which is a multiple of its alignment, as compilers do for aggregates.
+ * */
+template <typename T, typename... Fields> constexpr LayoutReport<sizeof...(Fields)> analyzeLayout(TypeList<Fields...>) {
+  LayoutReport<sizeof...(Fields)> report;
+  const std::array<std::pair<std::size_t, std::size_t>, sizeof...(Fields)> sizesAndAlignments{std::pair{sizeof(Fields), alignof(Fields)}...};
+  std::size_t end = 0;
+  for (std::size_t i = 0; i < sizesAndAlignments.size(); i++) {
+    auto &field = report.fields[i];
+    field.size = sizesAndAlignments[i].first;
+    field.alignment = sizesAndAlignments[i].second;
+    field.offset = LayoutAnalysis::alignUp(end, field.alignment);
+    field.paddingBefore = field.offset - end;
+    end = field.offset + field.size;
+    report.alignment = std::max(report.alignment, field.alignment);
+  }
+  report.size = LayoutAnalysis::alignUp(end, report.alignment);
+  report.trailingPadding = report.size - end;
+  report.paddingBytes = report.trailingPadding;
+  for (const auto &field : report.fields) {
+    report.paddingBytes += field.paddingBefore;
+  }
+  auto sortedFields = report.fields;
+  std::sort(std::begin(sortedFields), std::end(sortedFields), [](const FieldLayout &lhs, const FieldLayout &rhs) { return lhs.alignment > rhs.alignment; });
+  std::size_t sortedEnd = 0;
+  for (const auto &field : sortedFields) {
+    sortedEnd = LayoutAnalysis::alignUp(sortedEnd, field.alignment) + field.size;
+  }
+  report.optimalSize = LayoutAnalysis::alignUp(sortedEnd, report.alignment);
+  report.matchesCompiler = report.size == sizeof(T) && report.alignment == alignof(T);
+  return report;
+}
+
+/**
+ * Reports the offset of each field of an aggregate, the padding it wastes and its size with the best ordering of its fields, at compile time.
+ *
+ * The fields are found with structured bindings, so the aggregate must not have more than MaximumAnalyzedFieldCount fields, C array fields, reference
+ * fields or bases with fields.
+ * */
+template <typename T> constexpr auto analyzeLayout() { return analyzeLayout<T>(FieldTypes<T>{}); }
+
+/**
+ * Whether reordering the fields of the aggregate would not make it smaller, for use in static_assert.
+ * */
+template <typename T> constexpr bool isOptimallyOrdered() {
+  constexpr auto report = analyzeLayout<T>();
+  static_assert(report.matchesCompiler, "The layout of the type could not be analyzed.");
+  return report.size == report.optimalSize;
+}
+} // namespace Experiments
@@ -2,14 +2,26 @@
 #include <bitset>
 #include <chrono>
 #include <iostream>
+#include <latch>
+#include <string>
+#include <thread>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
 #include "atomic_types.hpp"
 #include "container_growth.hpp"
+#include "container_overhead.hpp"
 #include "experiment_runner.hpp"
+#include "formatting.hpp"
+#include "large_allocations.hpp"
 #include "memory.hpp"
+#include "memory_bandwidth.hpp"
+#include "memory_latency.hpp"
+#include "memory_resources.hpp"
+#include "number_formatting.hpp"
+#include "queue_handoff.hpp"
+#include "results.hpp"
 #include "shared_ptr.hpp"
 #include "sorting.hpp"
 #include "special_member_function_monitor.hpp"
@@ -17,6 +29,7 @@
 #include "struct_reordering.hpp"
 #include "types.hpp"
 #include "underlying_enum_types.hpp"
+#include "unordered_map_operations.hpp"
 
 namespace Experiments {
 void testVectorAssignment() {
@@ -26,8 +39,14 @@ void testVectorAssignment() {
       std::vector<U8> lhs(lhsSize);
       std::vector<U8> rhs(rhsSize);
       std::cout << "Testing assigning vector of size " << rhsSize << " to a vector of size " << lhsSize << ". ";
-      AllocationTrackerGuard allocationTrackerGuard(true, false);
-      lhs = rhs;
+      std::size_t allocations = 0;
+      {
+        AllocationTrackerGuard allocationTrackerGuard(true, false);
+        lhs = rhs;
+        allocations = allocationTrackerGuard.getAllocationsMade();
+      }
+      const auto metric = "Assigning " + std::to_string(rhsSize) + " elements to " + std::to_string(lhsSize) + " elements, allocations";
+      recordResult(metric, static_cast<double>(allocations), "allocations", MetricDirection::Exact);
     }
   }
 }
@@ -47,42 +66,76 @@ void testVectorAllocationsAndFreesWithBlocks() {
   }
 }
 
+void testConcurrentAllocationTracking() {
+  static constexpr std::size_t ThreadCount = 4;
+  static constexpr std::size_t VectorsPerThread = 1000;
+  std::cout << "Creating vectors from " << ThreadCount << " workers, where worker i creates " << VectorsPerThread << " * (i + 1) vectors.\n";
+  std::vector<std::size_t> threadAllocations(ThreadCount);
+  std::latch finished(ThreadCount);
+  std::latch released(1);
+  std::vector<std::jthread> threads;
+  threads.reserve(ThreadCount);
+  {
+    // The threads are kept alive until the summary is printed, so that their allocations are not attributed to exited threads.
+    AllocationTrackerGuard allocationTrackerGuard(false, false, true, false);
+    for (std::size_t i = 0; i < ThreadCount; i++) {
+      threads.emplace_back([i, &threadAllocations, &finished, &released]() {
+        AllocationTrackerGuard threadAllocationTrackerGuard(false, false, false, false);
+        for (std::size_t j = 0; j < VectorsPerThread * (i + 1); j++) {
+          std::vector<U8> vector(j + 1);
+        }
+        threadAllocations[i] = threadAllocationTrackerGuard.getAllocationsMadeByThisThread();
+        finished.count_down();
+        released.wait();
+      });
+    }
+    finished.wait();
+  }
+  released.count_down();
+  threads.clear();
+  for (std::size_t i = 0; i < ThreadCount; i++) {
+    std::cout << Indentation << "Worker " << i << " counted " << pluralizeAsNeeded(threadAllocations[i], "allocation") << " of its own.\n";
+    recordResult("Worker " + std::to_string(i) + " allocations", static_cast<double>(threadAllocations[i]), "allocations", MetricDirection::Exact);
+  }
+}
+
 void testInsertWithConflictingKeyInUnorderedMap() {
   std::unordered_map<int, int> map;
   map.insert(std::pair<int, int>{1, 2});
   map.insert(std::pair<int, int>{2, 3});
   map.insert(std::pair<int, int>{1, 3});
-  for (const auto [key, value] : map) {
+  for (const auto &[key, value] : map) {
     std::cout << key << ": " << value << '\n';
   }
 }
 
 void testPushBackAndEmplaceBackAllocations() {
+  using Monitor = SpecialMemberFunctionMonitor<struct PushBackAndEmplaceBackTag>;
   const auto printSpecialMemberFunctionCallCount = [](const std::string &situation) {
     std::cout << "When using " << situation << ", ";
-    SpecialMemberFunctionMonitor::print();
+    Monitor::print();
     std::cout << "\n";
-    SpecialMemberFunctionMonitor::reset();
+    Monitor::reset();
   };
   {
-    std::vector<SpecialMemberFunctionMonitor> vector;
-    SpecialMemberFunctionMonitor monitor;
+    std::vector<Monitor> vector;
+    Monitor monitor;
     vector.push_back(monitor);
   }
   printSpecialMemberFunctionCallCount("push_back() with lvalue");
   {
-    std::vector<SpecialMemberFunctionMonitor> vector;
+    std::vector<Monitor> vector;
     vector.push_back({});
   }
   printSpecialMemberFunctionCallCount("push_back() with rvalue");
   {
-    std::vector<SpecialMemberFunctionMonitor> vector;
-    SpecialMemberFunctionMonitor monitor;
+    std::vector<Monitor> vector;
+    Monitor monitor;
     vector.emplace_back(monitor);
   }
   printSpecialMemberFunctionCallCount("emplace_back() with lvalue");
   {
-    std::vector<SpecialMemberFunctionMonitor> vector;
+    std::vector<Monitor> vector;
     vector.emplace_back();
   }
   printSpecialMemberFunctionCallCount("emplace_back() constructor arguments");
@@ -117,27 +170,62 @@ void printStandard() noexcept {
   std::cout << ".\n";
 }
 
-[[nodiscard]] int main() {
+[[nodiscard]] int main(const int argc, const char *const *const argv) {
+  ExperimentOptions options;
+  try {
+    options = parseExperimentOptions(argc, argv);
+  } catch (const std::invalid_argument &exception) {
+    std::cerr << exception.what() << "\n" << getExperimentOptionsUsage();
+    return EXIT_FAILURE;
+  }
   printStandard();
-  ExperimentRunner(testVectorAssignment).run();
-  ExperimentRunner(testVectorAllocationsAndFreesWithBlocks).run();
-  ExperimentRunner(testVectorMaximumSize).run();
-  ExperimentRunner(testVectorGrowth).run();
-  ExperimentRunner(testVectorReserveGrowth).run();
-  ExperimentRunner(testUnorderedSetGrowth).run();
-  ExperimentRunner(testInsertWithConflictingKeyInUnorderedMap).run();
-  ExperimentRunner(testStringSize).run();
-  ExperimentRunner(testStringMaximumSize).run();
-  ExperimentRunner(testSmallStringOptimizationSize).run();
-  ExperimentRunner(testUnderlyingEnumTypes).run();
-  ExperimentRunner(testPushBackAndEmplaceBackAllocations).run();
-  ExperimentRunner(testSharedPointerMemoryAllocations).run();
-  ExperimentRunner(testSortAllocations).run();
-  ExperimentRunner(testStableSortAllocations).run();
-  ExperimentRunner(testSizesOfAtomicTypes).run();
-  ExperimentRunner(testStructReordering).run();
-  return EXIT_SUCCESS;
+  const std::vector<ExperimentRunner> experimentRunners{
+      ExperimentRunner("testVectorAssignment", testVectorAssignment),
+      ExperimentRunner("testMemoryBandwidth", testMemoryBandwidth),
+      ExperimentRunner("testMemoryLatency", testMemoryLatency),
+      ExperimentRunner("testLargeAllocations", testLargeAllocations),
+      ExperimentRunner("testVectorAllocationsAndFreesWithBlocks", testVectorAllocationsAndFreesWithBlocks),
+      ExperimentRunner("testConcurrentAllocationTracking", testConcurrentAllocationTracking),
+      ExperimentRunner("testVectorMaximumSize", testVectorMaximumSize),
+      ExperimentRunner("testVectorGrowth", testVectorGrowth),
+      ExperimentRunner("testVectorReserveGrowth", testVectorReserveGrowth),
+      ExperimentRunner("testGrowthVectorPushBack", testGrowthVectorPushBack),
+      ExperimentRunner("testUnorderedSetGrowth", testUnorderedSetGrowth),
+      ExperimentRunner("testFlatHashSetGrowth", testFlatHashSetGrowth),
+      ExperimentRunner("testHashSetThroughput", testHashSetThroughput),
+      ExperimentRunner("testContainerMemoryOverhead", testContainerMemoryOverhead),
+      ExperimentRunner("testMemoryResources", testMemoryResources),
+      ExperimentRunner("testInsertWithConflictingKeyInUnorderedMap", testInsertWithConflictingKeyInUnorderedMap),
+      ExperimentRunner("testUnorderedMapInsertion", testUnorderedMapInsertion),
+      ExperimentRunner("testHeterogeneousLookup", testHeterogeneousLookup),
+      ExperimentRunner("testNumberFormattingThroughput", testNumberFormattingThroughput),
+      ExperimentRunner("testStringSize", testStringSize),
+      ExperimentRunner("testStringMaximumSize", testStringMaximumSize),
+      ExperimentRunner("testSmallStringOptimizationSize", testSmallStringOptimizationSize),
+      ExperimentRunner("testSmallContainerInlineStorage", testSmallContainerInlineStorage),
+      ExperimentRunner("testSmallContainerThroughput", testSmallContainerThroughput),
+      ExperimentRunner("testUnderlyingEnumTypes", testUnderlyingEnumTypes),
+      ExperimentRunner("testPushBackAndEmplaceBackAllocations", testPushBackAndEmplaceBackAllocations),
+      ExperimentRunner("testHiddenCopies", testHiddenCopies),
+      ExperimentRunner("testSharedPointerMemoryAllocations", testSharedPointerMemoryAllocations),
+      ExperimentRunner("testSharedPointerContention", testSharedPointerContention),
+      ExperimentRunner("testSortAllocations", testSortAllocations),
+      ExperimentRunner("testStableSortAllocations", testStableSortAllocations),
+      ExperimentRunner("testSimdSortAllocations", testSimdSortAllocations),
+      ExperimentRunner("testSortingThroughput", testSortingThroughput),
+      ExperimentRunner("testSizesOfAtomicTypes", testSizesOfAtomicTypes),
+      ExperimentRunner("testAtomicCounterContention", testAtomicCounterContention),
+      ExperimentRunner("testConcurrentQueueHandoff", testConcurrentQueueHandoff),
+      ExperimentRunner("testStructReordering", testStructReordering),
+      ExperimentRunner("testStructLayouts", testStructLayouts),
+      ExperimentRunner("testRecordLayouts", testRecordLayouts)};
+  try {
+    return runExperiments(experimentRunners, options) ? EXIT_SUCCESS : EXIT_FAILURE;
+  } catch (const std::runtime_error &exception) {
+    std::cerr << exception.what() << "\n";
+    return EXIT_FAILURE;
+  }
 }
 } // namespace Experiments
 
-int main() { return Experiments::main(); }
+int main(int argc, char **argv) { return Experiments::main(argc, argv); }
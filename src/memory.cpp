@@ -1,29 +1,212 @@
 #include "memory.hpp"
 
+#include <algorithm>
 #include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
 #include <limits>
+#include <mutex>
+#include <new>
+#include <string_view>
+#include <thread>
+
+#include "formatting.hpp"
 
 static std::atomic<bool> writingAllocationMessages = false;
 static std::atomic<bool> writingDeallocationMessages = false;
 
-static std::atomic<std::size_t> allocationCount = 0;
+// Every allocation is preceded by a header which records its size, so that unsized deallocations can also be accounted for.
+static constexpr std::size_t AllocationHeaderSize = alignof(std::max_align_t);
+
+namespace {
+enum class ThreadCountersState : Experiments::U8 { Unregistered, Registered, Retired };
+
+/**
+ * Every thread counts its own allocations, so allocating threads never write to a shared cache line.
+ *
+ * The counters are only ever written by their owning thread, but are read by whichever thread asks for the totals.
+ * */
+struct alignas(64) ThreadAllocationCounters {
+  std::atomic<std::size_t> allocations = 0;
+  std::atomic<std::size_t> deallocations = 0;
+  std::atomic<std::size_t> allocatedBytes = 0;
+  std::atomic<std::size_t> freedBytes = 0;
+  std::array<std::atomic<std::size_t>, Experiments::AllocationSizeClassCount> sizeClassAllocations{};
+  ThreadAllocationCounters *next = nullptr;
+  Experiments::U64 threadNumber = 0;
+  ThreadCountersState state = ThreadCountersState::Unregistered;
+
+  void addTo(Experiments::AllocationStatistics &statistics) const noexcept {
+    statistics.allocations += allocations.load(std::memory_order_relaxed);
+    statistics.deallocations += deallocations.load(std::memory_order_relaxed);
+    statistics.allocatedBytes += allocatedBytes.load(std::memory_order_relaxed);
+    statistics.freedBytes += freedBytes.load(std::memory_order_relaxed);
+    for (std::size_t i = 0; i < sizeClassAllocations.size(); i++) {
+      statistics.sizeClassAllocations[i] += sizeClassAllocations[i].load(std::memory_order_relaxed);
+    }
+  }
+
+  void addTo(ThreadAllocationCounters &counters) const noexcept {
+    counters.allocations += allocations.load(std::memory_order_relaxed);
+    counters.deallocations += deallocations.load(std::memory_order_relaxed);
+    counters.allocatedBytes += allocatedBytes.load(std::memory_order_relaxed);
+    counters.freedBytes += freedBytes.load(std::memory_order_relaxed);
+    for (std::size_t i = 0; i < sizeClassAllocations.size(); i++) {
+      counters.sizeClassAllocations[i] += sizeClassAllocations[i].load(std::memory_order_relaxed);
+    }
+  }
+};
+
+/**
+ * Folds the counters of the thread into the totals of the exited threads when the thread exits.
+ * */
+struct ThreadAllocationCountersRetirer {
+  ~ThreadAllocationCountersRetirer();
+};
+} // namespace
+
+// Guards the list of registered threads and the assignment of thread numbers, but never the counters themselves.
+static std::mutex threadRegistryMutex;
+static ThreadAllocationCounters *registeredThreads = nullptr;
+static Experiments::U64 nextThreadNumber = 0;
+
+// Holds the totals of all threads which have exited, and the counts of allocations made by threads after they were retired.
+static ThreadAllocationCounters exitedThreadsCounters;
+
+static thread_local ThreadAllocationCounters threadAllocationCounters;
+
+/**
+ * A counter which only this thread writes can be incremented with a plain load and store, which compiles to an add without a lock prefix, and relaxed
+ * readers on other threads still never see a torn value. The counters of exited threads are shared by every retired thread, so they need a locked add.
+ * */
+static void addToCounter(std::atomic<std::size_t> &counter, const std::size_t value, const bool shared) noexcept {
+  if (shared) [[unlikely]] {
+    counter.fetch_add(value, std::memory_order_relaxed);
+  } else {
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+  }
+}
+
+// The peak of live bytes needs a process-wide view, so it is only tracked, through shared atomics, while a guard asks for it.
+static std::atomic<std::size_t> activePeakTrackers = 0;
+static std::atomic<std::ptrdiff_t> trackedLiveBytes = 0;
+static std::atomic<std::ptrdiff_t> trackedPeakLiveBytes = 0;
+
+// The buffer of the active AllocationTraceRecorder, if there is one. It is allocated with std::malloc, so recording never recurses into operator new.
+static std::atomic<Experiments::AllocationTraceSlot *> traceSlots = nullptr;
+static std::size_t traceCapacity = 0;
+static std::atomic<std::size_t> traceEventCount = 0;
+// The threads which may still be writing into the buffer, which AllocationTraceRecorder::stop() waits for before the buffer is read or freed.
+static std::atomic<std::size_t> traceWriters = 0;
+
+static void recordAllocationEvent(const Experiments::AllocationEventKind kind, const std::size_t size, const void *const pointer,
+                                  const Experiments::U64 threadNumber) noexcept {
+  // Announcing the write before loading the buffer again means that stop() either sees this writer or clears the buffer before it is loaded.
+  traceWriters.fetch_add(1);
+  if (auto *const slots = traceSlots.load(); slots != nullptr) {
+    const auto eventNumber = traceEventCount.fetch_add(1, std::memory_order_relaxed);
+    const auto timestamp = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    auto &slot = slots[eventNumber % traceCapacity];
+    const auto writtenSequence = Experiments::getWrittenAllocationTraceSequence(eventNumber);
+    // The slot is claimed by marking it as being written. The event is dropped if a newer event owns the slot, or if a thread which was given the same slot
+    // a lap earlier is still writing it, as two threads must never write the same slot at once.
+    auto sequence = slot.sequence.load(std::memory_order_relaxed);
+    while (sequence % 2 == 0 && sequence < writtenSequence) {
+      if (slot.sequence.compare_exchange_weak(sequence, writtenSequence + 1, std::memory_order_acquire, std::memory_order_relaxed)) {
+        slot.event = {static_cast<Experiments::U64>(timestamp), size, reinterpret_cast<std::uintptr_t>(pointer), threadNumber, kind};
+        slot.sequence.store(writtenSequence, std::memory_order_release);
+        break;
+      }
+    }
+  }
+  traceWriters.fetch_sub(1, std::memory_order_release);
+}
+
+static void raiseTrackedPeakLiveBytes(const std::ptrdiff_t liveBytes) noexcept {
+  auto peak = trackedPeakLiveBytes.load(std::memory_order_relaxed);
+  while (peak < liveBytes && !trackedPeakLiveBytes.compare_exchange_weak(peak, liveBytes, std::memory_order_relaxed)) {
+  }
+}
+
+static void registerThisThread() {
+  {
+    std::lock_guard lock(threadRegistryMutex);
+    threadAllocationCounters.threadNumber = nextThreadNumber++;
+    threadAllocationCounters.next = registeredThreads;
+    registeredThreads = &threadAllocationCounters;
+    threadAllocationCounters.state = ThreadCountersState::Registered;
+  }
+  // Registering the destructor of a thread-local object goes through the C library, so this does not recurse into operator new.
+  static thread_local ThreadAllocationCountersRetirer retirer;
+}
+
+ThreadAllocationCountersRetirer::~ThreadAllocationCountersRetirer() {
+  std::lock_guard lock(threadRegistryMutex);
+  auto **link = &registeredThreads;
+  while (*link != &threadAllocationCounters) {
+    link = &(*link)->next;
+  }
+  *link = threadAllocationCounters.next;
+  threadAllocationCounters.addTo(exitedThreadsCounters);
+  threadAllocationCounters.state = ThreadCountersState::Retired;
+}
+
+[[nodiscard]] static ThreadAllocationCounters &getCountersOfThisThread() {
+  if (threadAllocationCounters.state == ThreadCountersState::Unregistered) [[unlikely]] {
+    registerThisThread();
+  }
+  if (threadAllocationCounters.state == ThreadCountersState::Retired) [[unlikely]] {
+    return exitedThreadsCounters;
+  }
+  return threadAllocationCounters;
+}
+
+/**
+ * The header is widened to the alignment of over-aligned allocations, so that what follows it stays aligned.
+ * */
+[[nodiscard]] static std::size_t getAllocationHeaderSize(const std::size_t alignment) noexcept { return std::max(AllocationHeaderSize, alignment); }
 
-void *operator new(const std::size_t size) {
-  // This should be using "std::numeric_limits<decltype(allocationCount)::value_type>::max()", but LLVM does not have value_type for atomic.
-  if (allocationCount == std::numeric_limits<std::size_t>::max()) {
+[[nodiscard]] static void *allocateTracked(const std::size_t size, const std::size_t alignment) {
+  auto &counters = getCountersOfThisThread();
+  if (counters.allocations.load(std::memory_order_relaxed) == std::numeric_limits<std::size_t>::max()) {
+    throw std::bad_alloc();
+  }
+  const auto headerSize = getAllocationHeaderSize(alignment);
+  if (size > std::numeric_limits<std::size_t>::max() - headerSize - alignment) {
     throw std::bad_alloc();
   }
-  void *result = std::malloc(size);
-  if (result == nullptr) {
+  std::byte *block = nullptr;
+  if (alignment <= AllocationHeaderSize) {
+    block = static_cast<std::byte *>(std::malloc(headerSize + size));
+  } else {
+    block = static_cast<std::byte *>(std::aligned_alloc(alignment, (headerSize + size + alignment - 1) / alignment * alignment));
+  }
+  if (block == nullptr) {
     throw std::bad_alloc();
   }
+  *reinterpret_cast<std::size_t *>(block) = size;
   if (writingAllocationMessages) {
     std::cout << "Made an allocation of size " << size << ".\n";
   }
-  allocationCount++;
-  return result;
+  const auto shared = &counters == &exitedThreadsCounters;
+  addToCounter(counters.allocations, 1, shared);
+  addToCounter(counters.allocatedBytes, size, shared);
+  addToCounter(counters.sizeClassAllocations[Experiments::getAllocationSizeClass(size)], 1, shared);
+  if (activePeakTrackers.load(std::memory_order_relaxed) != 0) [[unlikely]] {
+    const auto signedSize = static_cast<std::ptrdiff_t>(size);
+    raiseTrackedPeakLiveBytes(trackedLiveBytes.fetch_add(signedSize, std::memory_order_relaxed) + signedSize);
+  }
+  if (traceSlots.load(std::memory_order_relaxed) != nullptr) [[unlikely]] {
+    recordAllocationEvent(Experiments::AllocationEventKind::Allocation, size, block + headerSize, counters.threadNumber);
+  }
+  return block + headerSize;
 }
 
+void *operator new(const std::size_t size) { return allocateTracked(size, AllocationHeaderSize); }
+
 void *operator new(const std::size_t size, const std::nothrow_t &) noexcept {
   try {
     return operator new(size);
@@ -32,21 +215,108 @@ void *operator new(const std::size_t size, const std::nothrow_t &) noexcept {
   }
 }
 
+void *operator new(const std::size_t size, const std::align_val_t alignment) { return allocateTracked(size, static_cast<std::size_t>(alignment)); }
+
+void *operator new(const std::size_t size, const std::align_val_t alignment, const std::nothrow_t &) noexcept {
+  try {
+    return operator new(size, alignment);
+  } catch (const std::exception &exception) {
+    return nullptr;
+  }
+}
+
+static void freeTrackedAllocation(void *pointer, const Experiments::AllocationEventKind kind, const std::size_t alignment) noexcept {
+  if (pointer == nullptr) {
+    return;
+  }
+  auto *const block = static_cast<std::byte *>(pointer) - getAllocationHeaderSize(alignment);
+  const auto size = *reinterpret_cast<const std::size_t *>(block);
+  auto &counters = getCountersOfThisThread();
+  const auto shared = &counters == &exitedThreadsCounters;
+  addToCounter(counters.deallocations, 1, shared);
+  addToCounter(counters.freedBytes, size, shared);
+  if (activePeakTrackers.load(std::memory_order_relaxed) != 0) [[unlikely]] {
+    trackedLiveBytes.fetch_sub(static_cast<std::ptrdiff_t>(size), std::memory_order_relaxed);
+  }
+  if (traceSlots.load(std::memory_order_relaxed) != nullptr) [[unlikely]] {
+    recordAllocationEvent(kind, size, pointer, counters.threadNumber);
+  }
+  std::free(block);
+}
+
 void operator delete(void *pointer) noexcept {
   if (writingDeallocationMessages) {
     std::cout << "Freed a pointer.\n";
   }
-  std::free(pointer);
+  freeTrackedAllocation(pointer, Experiments::AllocationEventKind::Deallocation, AllocationHeaderSize);
 }
 
 void operator delete(void *pointer, const std::size_t size) noexcept {
   if (writingDeallocationMessages) {
     std::cout << "Freed an array of size " << size << ".\n";
   }
-  std::free(pointer);
+  freeTrackedAllocation(pointer, Experiments::AllocationEventKind::SizedDeallocation, AllocationHeaderSize);
+}
+
+void operator delete(void *pointer, const std::align_val_t alignment) noexcept {
+  if (writingDeallocationMessages) {
+    std::cout << "Freed a pointer.\n";
+  }
+  freeTrackedAllocation(pointer, Experiments::AllocationEventKind::Deallocation, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void *pointer, const std::size_t size, const std::align_val_t alignment) noexcept {
+  if (writingDeallocationMessages) {
+    std::cout << "Freed an array of size " << size << ".\n";
+  }
+  freeTrackedAllocation(pointer, Experiments::AllocationEventKind::SizedDeallocation, static_cast<std::size_t>(alignment));
 }
 
 namespace Experiments {
+AllocationStatistics &AllocationStatistics::operator-=(const AllocationStatistics &rhs) noexcept {
+  allocations -= rhs.allocations;
+  deallocations -= rhs.deallocations;
+  allocatedBytes -= rhs.allocatedBytes;
+  freedBytes -= rhs.freedBytes;
+  for (std::size_t i = 0; i < sizeClassAllocations.size(); i++) {
+    sizeClassAllocations[i] -= rhs.sizeClassAllocations[i];
+  }
+  return *this;
+}
+
+std::ptrdiff_t AllocationStatistics::getLiveBytes() const noexcept { return static_cast<std::ptrdiff_t>(allocatedBytes - freedBytes); }
+
+[[nodiscard]] static AllocationStatistics getProcessAllocationStatistics() {
+  // Register this thread first, as doing so while holding the registry mutex would deadlock.
+  static_cast<void>(getCountersOfThisThread());
+  AllocationStatistics statistics;
+  std::lock_guard lock(threadRegistryMutex);
+  exitedThreadsCounters.addTo(statistics);
+  for (auto *counters = registeredThreads; counters != nullptr; counters = counters->next) {
+    counters->addTo(statistics);
+  }
+  return statistics;
+}
+
+[[nodiscard]] static std::size_t getThreadAllocationCount() { return getCountersOfThisThread().allocations.load(std::memory_order_relaxed); }
+
+[[nodiscard]] static std::vector<ThreadAllocationCount> getAllocationCountsPerThread() {
+  static_cast<void>(getCountersOfThisThread());
+  std::vector<ThreadAllocationCount> counts;
+  std::lock_guard lock(threadRegistryMutex);
+  std::size_t threadCount = 0;
+  for (auto *counters = registeredThreads; counters != nullptr; counters = counters->next) {
+    threadCount++;
+  }
+  // Reserving while holding the lock is safe because this thread is already registered.
+  counts.reserve(threadCount);
+  for (auto *counters = registeredThreads; counters != nullptr; counters = counters->next) {
+    const auto allocations = counters->allocations.load(std::memory_order_relaxed);
+    counts.push_back({counters->threadNumber, allocations, counters->allocatedBytes.load(std::memory_order_relaxed)});
+  }
+  return counts;
+}
+
 AllocationMessageEnabler::AllocationMessageEnabler() {
   if (writingAllocationMessages) {
     throw std::runtime_error("Tried to enable allocation messages a second time, this is not allowed.");
@@ -65,16 +335,212 @@ DeallocationMessageEnabler::DeallocationMessageEnabler() {
 
 DeallocationMessageEnabler::~DeallocationMessageEnabler() { writingDeallocationMessages = false; }
 
-AllocationTrackerGuard::AllocationTrackerGuard(bool allocationMessages, bool deallocationMessages)
-    : allocationCountAtStart(allocationCount),
+PeakLiveBytesTracker::PeakLiveBytesTracker() {
+  activePeakTrackers++;
+  liveBytesAtStart = trackedLiveBytes.load();
+  // An enclosing tracker keeps the peak it had seen so far in here, and gets it back when this tracker is destroyed.
+  enclosingPeakLiveBytes = trackedPeakLiveBytes.exchange(liveBytesAtStart);
+}
+
+std::size_t PeakLiveBytesTracker::getPeakLiveBytes() const noexcept {
+  return static_cast<std::size_t>(std::max(std::ptrdiff_t{0}, trackedPeakLiveBytes.load() - liveBytesAtStart));
+}
+
+PeakLiveBytesTracker::~PeakLiveBytesTracker() {
+  raiseTrackedPeakLiveBytes(enclosingPeakLiveBytes);
+  activePeakTrackers--;
+}
+
+AllocationTraceRecorder::AllocationTraceRecorder(const std::size_t eventCapacity)
+    : slots(static_cast<AllocationTraceSlot *>(std::malloc(eventCapacity * sizeof(AllocationTraceSlot)))), capacity(eventCapacity) {
+  if (slots == nullptr) {
+    throw std::bad_alloc();
+  }
+  if (traceSlots.load() != nullptr) {
+    std::free(slots);
+    throw std::runtime_error("Tried to record allocations with a second recorder, this is not allowed.");
+  }
+  std::uninitialized_value_construct_n(slots, capacity);
+  traceCapacity = capacity;
+  traceEventCount = 0;
+  traceSlots.store(slots);
+}
+
+void AllocationTraceRecorder::stop() noexcept {
+  if (recording) {
+    traceSlots.store(nullptr);
+    // Threads which loaded the buffer before it was cleared may still be writing to it.
+    while (traceWriters.load() != 0) {
+      std::this_thread::yield();
+    }
+    recording = false;
+  }
+}
+
+std::size_t AllocationTraceRecorder::getEventCount() const noexcept { return traceEventCount.load(std::memory_order_relaxed); }
+
+std::size_t AllocationTraceRecorder::getOverwrittenEventCount() const noexcept {
+  const auto eventCount = getEventCount();
+  return eventCount > capacity ? eventCount - capacity : 0;
+}
+
+std::size_t AllocationTraceRecorder::getRetainedEventCount() const noexcept {
+  std::size_t retainedEventCount = 0;
+  forEachEvent([&retainedEventCount](const AllocationEvent &) { retainedEventCount++; });
+  return retainedEventCount;
+}
+
+[[nodiscard]] static std::string_view getAllocationEventKindName(const AllocationEventKind kind) {
+  switch (kind) {
+  case AllocationEventKind::Allocation:
+    return "allocation";
+  case AllocationEventKind::Deallocation:
+    return "deallocation";
+  case AllocationEventKind::SizedDeallocation:
+    return "sized deallocation";
+  }
+  return "unknown";
+}
+
+void AllocationTraceRecorder::writeCsv(std::ostream &stream) const {
+  stream << "timestamp,thread,kind,size,address\n";
+  forEachEvent([&stream](const AllocationEvent &event) {
+    stream << event.timestamp << ',' << event.threadNumber << ',' << getAllocationEventKindName(event.kind) << ',' << event.size << ",0x";
+    stream << std::hex << event.address << std::dec << '\n';
+  });
+}
+
+static void writeBinaryInteger(std::ostream &stream, const U64 value) { stream.write(reinterpret_cast<const char *>(&value), sizeof(value)); }
+
+void AllocationTraceRecorder::writeBinary(std::ostream &stream) const {
+  stream.write("ALLOCTRC", 8);
+  writeBinaryInteger(stream, getRetainedEventCount());
+  // The fields are written one by one, as the padding after the kind is never initialized.
+  forEachEvent([&stream](const AllocationEvent &event) {
+    writeBinaryInteger(stream, event.timestamp);
+    writeBinaryInteger(stream, event.size);
+    writeBinaryInteger(stream, event.address);
+    writeBinaryInteger(stream, event.threadNumber);
+    stream.put(static_cast<char>(event.kind));
+  });
+}
+
+void AllocationTraceRecorder::writeMessages(std::ostream &stream) const {
+  bool madeAllocations = false;
+  forEachEvent([&stream, &madeAllocations](const AllocationEvent &event) {
+    switch (event.kind) {
+    case AllocationEventKind::Allocation:
+      stream << "Made an allocation of size " << event.size << ".\n";
+      madeAllocations = true;
+      break;
+    case AllocationEventKind::Deallocation:
+      stream << "Freed a pointer.\n";
+      break;
+    case AllocationEventKind::SizedDeallocation:
+      stream << "Freed an array of size " << event.size << ".\n";
+      break;
+    }
+  });
+  if (!madeAllocations) {
+    stream << "Made no allocations.\n";
+  }
+}
+
+AllocationTraceRecorder::~AllocationTraceRecorder() {
+  stop();
+  std::destroy_n(slots, capacity);
+  std::free(slots);
+}
+
+AllocationTrackerGuard::AllocationTrackerGuard(bool allocationMessages, bool deallocationMessages, bool threadSummary, bool peakTracking)
+    : threadAllocationCountsAtStart(threadSummary ? getAllocationCountsPerThread() : std::vector<ThreadAllocationCount>{}),
+      statisticsAtStart(getProcessAllocationStatistics()), threadAllocationCountAtStart(getThreadAllocationCount()), writingThreadSummary(threadSummary),
+      optionalPeakLiveBytesTracker(peakTracking ? std::make_optional<PeakLiveBytesTracker>() : std::nullopt),
       optionalAllocationMessageEnabler(allocationMessages ? std::make_optional<AllocationMessageEnabler>() : std::nullopt),
       optionalDeallocationMessageEnabler(deallocationMessages ? std::make_optional<DeallocationMessageEnabler>() : std::nullopt) {}
 
-std::size_t AllocationTrackerGuard::getAllocationsMade() const noexcept { return allocationCount - allocationCountAtStart; }
+std::size_t AllocationTrackerGuard::getAllocationsMade() const { return getStatistics().allocations; }
+
+std::size_t AllocationTrackerGuard::getAllocationsMadeByThisThread() const { return getThreadAllocationCount() - threadAllocationCountAtStart; }
+
+AllocationStatistics AllocationTrackerGuard::getStatistics() const {
+  auto statistics = getProcessAllocationStatistics();
+  statistics -= statisticsAtStart;
+  if (optionalPeakLiveBytesTracker) {
+    statistics.peakLiveBytes = optionalPeakLiveBytesTracker->getPeakLiveBytes();
+  }
+  return statistics;
+}
+
+std::vector<ThreadAllocationCount> AllocationTrackerGuard::getAllocationsMadePerThread() const {
+  auto counts = getAllocationCountsPerThread();
+  for (auto &count : counts) {
+    const auto matchesThread = [&count](const ThreadAllocationCount &atStart) { return atStart.threadNumber == count.threadNumber; };
+    const auto atStart = std::find_if(std::begin(threadAllocationCountsAtStart), std::end(threadAllocationCountsAtStart), matchesThread);
+    if (atStart != std::end(threadAllocationCountsAtStart)) {
+      count.allocations -= atStart->allocations;
+      count.allocatedBytes -= atStart->allocatedBytes;
+    }
+  }
+  counts.erase(std::remove_if(std::begin(counts), std::end(counts), [](const ThreadAllocationCount &count) { return count.allocations == 0; }),
+               std::end(counts));
+  std::sort(std::begin(counts), std::end(counts),
+            [](const ThreadAllocationCount &a, const ThreadAllocationCount &b) { return a.threadNumber < b.threadNumber; });
+  return counts;
+}
+
+void AllocationTrackerGuard::printThreadSummary() const {
+  const auto counts = getAllocationsMadePerThread();
+  const auto allocationsMade = getAllocationsMade();
+  std::cout << "Made " << pluralizeAsNeeded(allocationsMade, "allocation") << " in total.\n";
+  // Whatever the threads which are still running did not make was made by threads which exited in the meantime.
+  auto exitedThreadsAllocations = allocationsMade;
+  for (const auto &count : counts) {
+    std::cout << Indentation << "Thread " << count.threadNumber << " made " << pluralizeAsNeeded(count.allocations, "allocation");
+    std::cout << " of " << toStringWithThousandsSeparators(count.allocatedBytes) << " bytes.\n";
+    exitedThreadsAllocations -= std::min(exitedThreadsAllocations, count.allocations);
+  }
+  if (exitedThreadsAllocations != 0) {
+    std::cout << Indentation << "Threads which have exited made " << pluralizeAsNeeded(exitedThreadsAllocations, "allocation") << ".\n";
+  }
+}
 
 AllocationTrackerGuard::~AllocationTrackerGuard() noexcept {
   if (optionalAllocationMessageEnabler && getAllocationsMade() == 0) {
     std::cout << "Made no allocations.\n";
   }
+  if (writingThreadSummary) {
+    printThreadSummary();
+  }
+}
+
+void printMemoryUsage(const AllocationStatistics &statistics) {
+  std::cout << Indentation << "Allocated " << toStringWithThousandsSeparators(statistics.allocatedBytes) << " bytes in ";
+  std::cout << pluralizeAsNeeded(statistics.allocations, "allocation") << " and freed " << toStringWithThousandsSeparators(statistics.freedBytes);
+  std::cout << " bytes in " << pluralizeAsNeeded(statistics.deallocations, "deallocation") << ".\n";
+  std::cout << Indentation << "Live bytes peaked at " << toStringWithThousandsSeparators(statistics.peakLiveBytes) << " and ended at ";
+  const auto liveBytes = statistics.getLiveBytes();
+  if (liveBytes < 0) {
+    std::cout << "-";
+  }
+  std::cout << toStringWithThousandsSeparators(static_cast<U64>(liveBytes < 0 ? -liveBytes : liveBytes)) << ".\n";
+}
+
+void printSizeClassHistogram(const AllocationStatistics &statistics) {
+  std::cout << Indentation << "Allocations by size:\n";
+  for (std::size_t sizeClass = 0; sizeClass < statistics.sizeClassAllocations.size(); sizeClass++) {
+    const auto allocations = statistics.sizeClassAllocations[sizeClass];
+    if (allocations == 0) {
+      continue;
+    }
+    std::cout << Indentation << Indentation;
+    if (sizeClass == 0) {
+      std::cout << "0";
+    } else {
+      const auto minimum = std::size_t{1} << (sizeClass - 1);
+      std::cout << "[" << toStringWithThousandsSeparators(minimum) << ", " << toStringWithThousandsSeparators(2 * minimum) << ")";
+    }
+    std::cout << ": " << toStringWithThousandsSeparators(allocations) << "\n";
+  }
 }
 } // namespace Experiments
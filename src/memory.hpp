@@ -1,9 +1,16 @@
 #pragma once
 
+#include <array>
 #include <atomic>
+#include <bit>
+#include <cstddef>
 #include <iostream>
+#include <limits>
 #include <memory>
 #include <optional>
+#include <vector>
+
+#include "types.hpp"
 
 namespace Experiments {
 class AllocationMessageEnabler {
@@ -20,16 +27,203 @@ public:
   ~DeallocationMessageEnabler();
 };
 
+/**
+ * Allocations are grouped into power-of-two size classes, where size class i holds sizes in [2^(i - 1), 2^i) and size class 0 holds empty allocations.
+ * */
+static constexpr std::size_t AllocationSizeClassCount = std::numeric_limits<std::size_t>::digits + 1;
+
+[[nodiscard]] constexpr std::size_t getAllocationSizeClass(const std::size_t size) noexcept { return std::bit_width(size); }
+
+struct AllocationStatistics {
+  std::size_t allocations = 0;
+  std::size_t deallocations = 0;
+  std::size_t allocatedBytes = 0;
+  std::size_t freedBytes = 0;
+  std::array<std::size_t, AllocationSizeClassCount> sizeClassAllocations{};
+  /**
+   * Only set by AllocationTrackerGuard, which leaves it zero if it does not track the peak, and by TrackingAllocator.
+   * */
+  std::size_t peakLiveBytes = 0;
+
+  AllocationStatistics &operator-=(const AllocationStatistics &rhs) noexcept;
+
+  /**
+   * Negative if more bytes were freed than allocated, which happens when memory allocated earlier is freed.
+   * */
+  [[nodiscard]] std::ptrdiff_t getLiveBytes() const noexcept;
+};
+
+struct ThreadAllocationCount {
+  /**
+   * Threads are numbered in the order in which they first allocated, starting from zero.
+   * */
+  U64 threadNumber;
+  std::size_t allocations;
+  std::size_t allocatedBytes;
+};
+
+/**
+ * Tracks the peak of bytes allocated and not yet freed by the whole process while it is alive, relative to when it was created.
+ *
+ * Unlike the other counters, this needs shared atomics which every allocating thread writes to, so it distorts multithreaded workloads.
+ * Trackers may be nested, but trackers whose lifetimes overlap without nesting will underestimate their peaks.
+ * */
+class PeakLiveBytesTracker {
+  std::ptrdiff_t liveBytesAtStart;
+  std::ptrdiff_t enclosingPeakLiveBytes;
+
+public:
+  PeakLiveBytesTracker();
+
+  PeakLiveBytesTracker(const PeakLiveBytesTracker &) = delete;
+
+  PeakLiveBytesTracker &operator=(const PeakLiveBytesTracker &) = delete;
+
+  [[nodiscard]] std::size_t getPeakLiveBytes() const noexcept;
+
+  ~PeakLiveBytesTracker();
+};
+
+/**
+ * Counts the allocations made while it is alive.
+ *
+ * Each thread counts its own allocations, so tracking does not serialize allocating threads. The counts of all threads are only combined when read.
+ * */
 class AllocationTrackerGuard {
-  std::size_t allocationCountAtStart;
+  std::vector<ThreadAllocationCount> threadAllocationCountsAtStart;
+  AllocationStatistics statisticsAtStart;
+  std::size_t threadAllocationCountAtStart;
+  bool writingThreadSummary;
+  std::optional<PeakLiveBytesTracker> optionalPeakLiveBytesTracker;
   std::optional<AllocationMessageEnabler> optionalAllocationMessageEnabler;
   std::optional<DeallocationMessageEnabler> optionalDeallocationMessageEnabler;
 
 public:
-  explicit AllocationTrackerGuard(bool allocationMessages, bool deallocationMessages);
+  /**
+   * If threadSummary is set, the allocations made by each thread are printed when the guard is destroyed.
+   *
+   * Tracking the peak of live bytes makes every allocation on every thread update shared atomics, so it is only done if peakTracking is set, and should
+   * not be while measuring.
+   * */
+  explicit AllocationTrackerGuard(bool allocationMessages, bool deallocationMessages, bool threadSummary = false, bool peakTracking = false);
+
+  /**
+   * Returns the number of allocations made by all threads of the process.
+   * */
+  [[nodiscard]] std::size_t getAllocationsMade() const;
 
-  [[nodiscard]] std::size_t getAllocationsMade() const noexcept;
+  [[nodiscard]] std::size_t getAllocationsMadeByThisThread() const;
+
+  /**
+   * Returns what all threads of the process allocated and freed.
+   * */
+  [[nodiscard]] AllocationStatistics getStatistics() const;
+
+  /**
+   * Returns the number of allocations made by each running thread which allocated, sorted by thread number.
+   *
+   * Only accounts for allocations made before the guard for threads which were running when it was created if threadSummary was set.
+   * */
+  [[nodiscard]] std::vector<ThreadAllocationCount> getAllocationsMadePerThread() const;
+
+  void printThreadSummary() const;
 
   virtual ~AllocationTrackerGuard() noexcept;
 };
-} // namespace Experiments
\ No newline at end of file
+
+enum class AllocationEventKind : U8 { Allocation, Deallocation, SizedDeallocation };
+
+struct AllocationEvent {
+  /**
+   * Nanoseconds since the epoch of std::chrono::steady_clock.
+   * */
+  U64 timestamp;
+  U64 size;
+  U64 address;
+  U64 threadNumber;
+  AllocationEventKind kind;
+};
+
+/**
+ * A slot of the ring buffer of AllocationTraceRecorder.
+ *
+ * Its sequence is zero while it is empty, the written sequence of the event it holds once that event is written, and one more while it is being written.
+ * */
+struct AllocationTraceSlot {
+  std::atomic<U64> sequence = 0;
+  AllocationEvent event{};
+};
+
+[[nodiscard]] constexpr U64 getWrittenAllocationTraceSequence(const std::size_t eventNumber) noexcept { return 2 * (static_cast<U64>(eventNumber) + 1); }
+
+/**
+ * Records every allocation and deallocation made while it is recording into a preallocated ring buffer.
+ *
+ * Recording an event only claims a number with an atomic increment and fills in its slot, so it costs a few nanoseconds instead of the microseconds which
+ * writing a message costs. Once the buffer is full, the oldest events are overwritten, and an event whose slot another thread is still writing is dropped.
+ * The events can only be read once the recording has stopped, which waits for the threads still recording into the buffer.
+ * */
+class AllocationTraceRecorder {
+  AllocationTraceSlot *slots;
+  std::size_t capacity;
+  bool recording = true;
+
+public:
+  static constexpr std::size_t DefaultCapacity = 1u << 20u;
+
+  explicit AllocationTraceRecorder(std::size_t eventCapacity = DefaultCapacity);
+
+  AllocationTraceRecorder(const AllocationTraceRecorder &) = delete;
+
+  AllocationTraceRecorder &operator=(const AllocationTraceRecorder &) = delete;
+
+  void stop() noexcept;
+
+  /**
+   * Returns the number of events recorded, including those which were overwritten or dropped.
+   * */
+  [[nodiscard]] std::size_t getEventCount() const noexcept;
+
+  [[nodiscard]] std::size_t getOverwrittenEventCount() const noexcept;
+
+  /**
+   * Returns the number of events which were neither overwritten nor dropped, which is only final once the recording has stopped.
+   * */
+  [[nodiscard]] std::size_t getRetainedEventCount() const noexcept;
+
+  /**
+   * Calls the function with each retained event, from the oldest to the newest, and should only be called once the recording has stopped.
+   * */
+  template <typename Function> void forEachEvent(Function function) const {
+    const auto eventCount = getEventCount();
+    for (auto i = getOverwrittenEventCount(); i < eventCount; i++) {
+      const auto &slot = slots[i % capacity];
+      if (slot.sequence.load(std::memory_order_acquire) == getWrittenAllocationTraceSequence(i)) {
+        function(slot.event);
+      }
+    }
+  }
+
+  void writeCsv(std::ostream &stream) const;
+
+  /**
+   * Writes a "ALLOCTRC" magic and the number of events as a 64-bit integer, followed by the timestamp, size, address and thread number of each event as
+   * 64-bit integers and its kind as a byte, all in the byte order of the machine.
+   * */
+  void writeBinary(std::ostream &stream) const;
+
+  /**
+   * Writes the same messages which AllocationTrackerGuard writes when it is asked for allocation and deallocation messages.
+   * */
+  void writeMessages(std::ostream &stream) const;
+
+  ~AllocationTraceRecorder();
+};
+
+/**
+ * Printing allocates, so the statistics should be taken before printing them.
+ * */
+void printMemoryUsage(const AllocationStatistics &statistics);
+
+void printSizeClassHistogram(const AllocationStatistics &statistics);
+} // namespace Experiments
@@ -0,0 +1,122 @@
+#include "memory_bandwidth.hpp"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "experiment_runner.hpp"
+#include "formatting.hpp"
+#include "memory.hpp"
+#include "non_temporal_copy.hpp"
+#include "results.hpp"
+#include "system_memory.hpp"
+#include "timing.hpp"
+#include "types.hpp"
+
+namespace Experiments {
+namespace {
+struct CopyKernel {
+  std::string_view name;
+  /**
+   * Copies the source into the destination, which has the same size, and may reallocate the destination to do so.
+   * */
+  void (*copy)(std::vector<U8> &destination, const std::vector<U8> &source);
+};
+} // namespace
+
+static std::vector<CopyKernel> makeCopyKernels() {
+  std::vector<CopyKernel> copyKernels{
+      {"assign", [](std::vector<U8> &destination, const std::vector<U8> &source) { destination = source; }},
+      {"assign to empty",
+       [](std::vector<U8> &destination, const std::vector<U8> &source) {
+         // Freeing the destination first makes the assignment allocate, as assigning into a vector which was moved from would.
+         destination = std::vector<U8>();
+         destination = source;
+       }},
+      {"std::copy",
+       [](std::vector<U8> &destination, const std::vector<U8> &source) { std::copy(std::begin(source), std::end(source), std::begin(destination)); }},
+      {"std::memcpy", [](std::vector<U8> &destination, const std::vector<U8> &source) { std::memcpy(destination.data(), source.data(), source.size()); }},
+      {"std::memmove", [](std::vector<U8> &destination, const std::vector<U8> &source) { std::memmove(destination.data(), source.data(), source.size()); }},
+  };
+  if (__builtin_cpu_supports("avx")) {
+    copyKernels.push_back({"AVX streaming", [](std::vector<U8> &destination, const std::vector<U8> &source) {
+                             copyWithNonTemporalStores(destination.data(), source.data(), source.size());
+                           }});
+  }
+  return copyKernels;
+}
+
+void testMemoryBandwidth() {
+  static constexpr std::size_t MinimumWorkingSetSize = 4 * 1024;
+  // Small buffers are copied many times, so that every measurement copies about this many bytes.
+  static constexpr std::size_t BytesPerMeasurement = 64 * 1024 * 1024;
+  static constexpr std::size_t Repetitions = 3;
+  static constexpr int SizeWidth = 10;
+  static constexpr int ColumnWidth = 17;
+  static constexpr U32 BandwidthDecimalPlaces = 2;
+  const auto maximumWorkingSetSize = std::max(MinimumWorkingSetSize, getExperimentOptions().maximumWorkingSetSize);
+  const auto copyKernels = makeCopyKernels();
+  std::cout << "Testing the bandwidth of copying, in GB copied per second at the median, for working sets of " << toByteSizeString(MinimumWorkingSetSize)
+            << " to " << toByteSizeString(maximumWorkingSetSize) << ".\n";
+  std::cout << Indentation << "The working set is the source and the destination together, so each copies half of it.\n";
+  printReportedCacheSizes();
+  if (!__builtin_cpu_supports("avx")) {
+    std::cout << Indentation << "The processor does not support AVX, so copying with non-temporal stores is skipped.\n";
+  }
+  std::cout << Indentation << std::setw(SizeWidth) << "";
+  for (const auto &copyKernel : copyKernels) {
+    std::cout << std::setw(ColumnWidth) << copyKernel.name;
+  }
+  std::cout << "\n";
+  // The working sets at which assigning into a destination of the same size allocated, with how many allocations it made.
+  std::vector<std::pair<std::size_t, std::size_t>> reallocatingAssignments;
+  for (auto workingSetSize = MinimumWorkingSetSize; workingSetSize <= maximumWorkingSetSize; workingSetSize *= 2) {
+    const auto bufferSize = workingSetSize / 2;
+    std::vector<U8> source(bufferSize);
+    std::iota(std::begin(source), std::end(source), U8{1});
+    std::vector<U8> destination(bufferSize);
+    const auto passes = std::max<std::size_t>(1, BytesPerMeasurement / bufferSize);
+    std::cout << Indentation << std::setw(SizeWidth) << toByteSizeString(workingSetSize);
+    for (const auto &copyKernel : copyKernels) {
+      const auto statistics = measureRepeatedly(
+          Repetitions, []() {},
+          [&copyKernel, &destination, &source, passes]() {
+            for (std::size_t pass = 0; pass < passes; pass++) {
+              copyKernel.copy(destination, source);
+              preventOptimization(destination);
+            }
+          });
+      if (destination != source) {
+        throw std::logic_error("Copying with " + std::string(copyKernel.name) + " did not produce a copy of the source.");
+      }
+      const auto gigabytesPerSecond = static_cast<double>(bufferSize * passes) / statistics.median / 1e9;
+      std::cout << std::setw(ColumnWidth) << toFixedPrecisionString(gigabytesPerSecond, BandwidthDecimalPlaces);
+      recordResult(std::string(copyKernel.name) + " of a " + toByteSizeString(workingSetSize) + " working set", gigabytesPerSecond, "GB/s",
+                   MetricDirection::HigherIsBetter);
+    }
+    std::cout << "\n";
+    AllocationTrackerGuard allocationTrackerGuard(false, false, false, false);
+    destination = source;
+    const auto allocations = allocationTrackerGuard.getAllocationsMade();
+    if (allocations != 0) {
+      reallocatingAssignments.emplace_back(workingSetSize, allocations);
+    }
+  }
+  if (reallocatingAssignments.empty()) {
+    std::cout << Indentation << "Assigning into a vector of the same size reused its capacity for every working set.\n";
+  } else {
+    for (const auto &[workingSetSize, allocations] : reallocatingAssignments) {
+      std::cout << Indentation << "Assigning into a vector of the same size made " << pluralizeAsNeeded(allocations, "allocation") << " for a working set of "
+                << toByteSizeString(workingSetSize) << ".\n";
+    }
+  }
+}
+} // namespace Experiments
@@ -0,0 +1,10 @@
+#pragma once
+
+namespace Experiments {
+/**
+ * Measures the bandwidth of copying buffers whose source and destination together span from 4 KiB up to the maximum working set, through vector
+ * assignment, std::copy, std::memcpy, std::memmove and AVX non-temporal stores, if the processor supports AVX, so that the sizes at which the copies
+ * stop fitting in each cache level show as drops in bandwidth.
+ * */
+void testMemoryBandwidth();
+} // namespace Experiments
@@ -0,0 +1,256 @@
+#include "memory_latency.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <optional>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+
+#include "experiment_runner.hpp"
+#include "formatting.hpp"
+#include "results.hpp"
+#include "system_memory.hpp"
+#include "timing.hpp"
+#include "types.hpp"
+
+namespace Experiments {
+static constexpr std::size_t LatencyRepetitions = 3;
+static constexpr std::size_t LoadsPerMeasurement = std::size_t{1} << 21u;
+/**
+ * The chased pointers are this far apart, so that each is in its own line on processors with lines of up to this size.
+ * */
+static constexpr std::size_t ChasedNodeSize = 64;
+/**
+ * A latency this many times that of the start of a plateau starts a new one.
+ * */
+static constexpr double PlateauJumpRatio = 1.5;
+static constexpr U32 LatencyDecimalPlaces = 2;
+
+/**
+ * Returns a permutation of the indices below the count which is a single cycle, with Sattolo's algorithm, so that following it visits every index.
+ * */
+static std::vector<U32> makeRandomCycle(const std::size_t count, std::mt19937_64 &generator) {
+  std::vector<U32> next(count);
+  std::iota(std::begin(next), std::end(next), U32{0});
+  for (auto i = count - 1; i > 0; i--) {
+    std::uniform_int_distribution<std::size_t> distribution(0, i - 1);
+    std::swap(next[i], next[distribution(generator)]);
+  }
+  return next;
+}
+
+static void storePointer(U8 *const location, const void *const pointer) noexcept { *reinterpret_cast<const void **>(location) = pointer; }
+
+/**
+ * Follows the chain of pointers from the node, so that every load has to wait for the previous one, and returns the node it stopped at.
+ * */
+[[nodiscard]] static const void *chase(const void *node, const std::size_t loads) noexcept {
+  for (std::size_t i = 0; i < loads; i++) {
+    node = *static_cast<const void *const *>(node);
+  }
+  return node;
+}
+
+/**
+ * Returns the median nanoseconds per load of chasing the pointers from the node.
+ * */
+[[nodiscard]] static double measureLoadLatency(const void *node, const std::size_t loads) {
+  const auto statistics = measureRepeatedly(LatencyRepetitions, []() {}, [&node, loads]() { node = chase(node, loads); });
+  preventOptimization(node);
+  return statistics.median / static_cast<double>(loads) * 1e9;
+}
+
+namespace {
+struct LatencyMeasurement {
+  double nanoseconds;
+  /**
+   * The fraction of the working set which huge pages backed.
+   * */
+  double hugePageFraction;
+};
+
+struct LatencyPlateau {
+  std::size_t firstIndex;
+  std::size_t lastIndex;
+};
+} // namespace
+
+[[nodiscard]] static LatencyMeasurement measureWorkingSetLatency(const std::size_t workingSetSize, const HugePageAdvice advice, std::mt19937_64 &generator) {
+  MappedMemory memory(workingSetSize, advice);
+  const auto nodeCount = workingSetSize / ChasedNodeSize;
+  const auto next = makeRandomCycle(nodeCount, generator);
+  for (std::size_t i = 0; i < nodeCount; i++) {
+    storePointer(memory.data() + i * ChasedNodeSize, memory.data() + next[i] * ChasedNodeSize);
+  }
+  const auto nanoseconds = measureLoadLatency(memory.data(), LoadsPerMeasurement);
+  return {nanoseconds, static_cast<double>(memory.getHugePageBackedSize()) / static_cast<double>(workingSetSize)};
+}
+
+/**
+ * Groups consecutive working sets whose latencies are close into plateaus, each of which fits in one level of the memory hierarchy.
+ *
+ * A plateau of a single working set between two others is where a level only partly fits, so it is merged into the next plateau.
+ * */
+[[nodiscard]] static std::vector<LatencyPlateau> findLatencyPlateaus(const std::vector<double> &latencies) {
+  std::vector<LatencyPlateau> plateaus{{0, 0}};
+  for (std::size_t i = 1; i < latencies.size(); i++) {
+    auto &plateau = plateaus.back();
+    if (latencies[i] <= latencies[plateau.firstIndex] * PlateauJumpRatio) {
+      plateau.lastIndex = i;
+    } else if (plateaus.size() > 1 && plateau.firstIndex == plateau.lastIndex) {
+      plateau = {i, i};
+    } else {
+      plateaus.push_back({i, i});
+    }
+  }
+  return plateaus;
+}
+
+/**
+ * Chases pairs of dependent loads through random blocks, the second load of each pair at the given offset from the first, and returns the median
+ * nanoseconds per pair.
+ * */
+[[nodiscard]] static double measurePairLatency(const MappedMemory &memory, const std::vector<U32> &next, const std::size_t blockSize,
+                                               const std::size_t offset) {
+  for (std::size_t i = 0; i < next.size(); i++) {
+    auto *const block = memory.data() + i * blockSize;
+    storePointer(block, block + offset);
+    storePointer(block + offset, memory.data() + next[i] * blockSize);
+  }
+  return measureLoadLatency(memory.data(), LoadsPerMeasurement) * 2;
+}
+
+/**
+ * Infers the cache line size as the smallest offset at which the second load of a pair costs more than half of what a second load in another line does.
+ * */
+static void testCacheLineSize(std::mt19937_64 &generator) {
+  static constexpr std::size_t BlockSize = 1024;
+  static constexpr std::array<std::size_t, 7> Offsets{8, 16, 32, 64, 128, 256, 512};
+  // Large enough that the blocks miss the first two levels of cache on most processors.
+  static constexpr std::size_t MaximumWorkingSetSize = 32 * 1024 * 1024;
+  // A difference between the fastest and the last offset below this fraction of the fastest latency is too small to tell misses from noise.
+  static constexpr double MinimumMissPenaltyRatio = 0.25;
+  static constexpr int OffsetWidth = 4;
+  const auto workingSetSize = std::min(MaximumWorkingSetSize, std::max(BlockSize * 2, getExperimentOptions().maximumWorkingSetSize));
+  const MappedMemory memory(workingSetSize, HugePageAdvice::Enabled);
+  const auto next = makeRandomCycle(workingSetSize / BlockSize, generator);
+  std::cout << Indentation << "Pairs of dependent loads in random blocks of a " << toByteSizeString(workingSetSize)
+            << " working set, with the second load at an offset from the first:\n";
+  // The first pass faults the pages in and fills the TLB, so it is discarded.
+  static_cast<void>(measurePairLatency(memory, next, BlockSize, Offsets.front()));
+  std::vector<double> latencies;
+  for (const auto offset : Offsets) {
+    latencies.push_back(measurePairLatency(memory, next, BlockSize, offset));
+    std::cout << Indentation << Indentation << std::setw(OffsetWidth) << offset << " bytes: " << toFixedPrecisionString(latencies.back(), LatencyDecimalPlaces)
+              << " ns per pair\n";
+  }
+  // A single sample can be slowed by noise, so the fastest offset is taken as the latency of a second load in the same line.
+  const auto hitLatency = *std::min_element(std::begin(latencies), std::end(latencies));
+  const auto missPenalty = latencies.back() - hitLatency;
+  std::optional<std::size_t> cacheLineSize;
+  if (missPenalty > hitLatency * MinimumMissPenaltyRatio) {
+    for (std::size_t i = 0; i < Offsets.size() && !cacheLineSize; i++) {
+      if (latencies[i] - hitLatency > missPenalty / 2) {
+        cacheLineSize = Offsets[i];
+      }
+    }
+  }
+  const auto reportedCacheLineSize = sysconf(_SC_LEVEL1_DCACHE_LINESIZE);
+  if (cacheLineSize) {
+    std::cout << Indentation << "The cache line size seems to be " << toByteSizeString(*cacheLineSize);
+    recordResult("Cache line size", static_cast<double>(*cacheLineSize), "bytes", MetricDirection::Exact);
+  } else {
+    std::cout << Indentation << "The second loads did not get slower with the offset, so the cache line size could not be inferred";
+  }
+  if (reportedCacheLineSize > 0) {
+    std::cout << ", and the system reports " << toByteSizeString(static_cast<U64>(reportedCacheLineSize));
+  }
+  std::cout << ".\n";
+}
+
+void testMemoryLatency() {
+  static constexpr std::size_t MinimumWorkingSetSize = 1024;
+  static constexpr int SizeWidth = 10;
+  static constexpr int ColumnWidth = 20;
+  const auto maximumWorkingSetSize = std::max(MinimumWorkingSetSize, getExperimentOptions().maximumWorkingSetSize);
+  const auto pageSize = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+  const auto transparentHugePageMode = getTransparentHugePageMode();
+  const auto hugePagesAvailable = !transparentHugePageMode.empty() && transparentHugePageMode != "never";
+  std::mt19937_64 generator(0);
+  std::cout << "Testing the latency of dependent loads, in nanoseconds per load at the median, for working sets of " << toByteSizeString(MinimumWorkingSetSize)
+            << " to " << toByteSizeString(maximumWorkingSetSize) << ".\n";
+  printReportedCacheSizes();
+  if (hugePagesAvailable) {
+    std::cout << Indentation << "Transparent huge pages are set to " << transparentHugePageMode << ", and are requested with madvise() or disabled.\n";
+  } else {
+    std::cout << Indentation << "Transparent huge pages are not available, so only small pages are measured.\n";
+  }
+  const auto smallPagesName = toByteSizeString(pageSize) + " pages";
+  std::cout << Indentation << std::setw(SizeWidth) << "" << std::setw(ColumnWidth) << smallPagesName;
+  if (hugePagesAvailable) {
+    std::cout << std::setw(ColumnWidth) << "Huge pages" << std::setw(ColumnWidth) << "Huge page backed";
+  }
+  std::cout << "\n";
+  std::vector<std::size_t> workingSetSizes;
+  std::vector<double> latencies;
+  for (auto workingSetSize = MinimumWorkingSetSize; workingSetSize <= maximumWorkingSetSize; workingSetSize *= 2) {
+    const auto smallPages = measureWorkingSetLatency(workingSetSize, hugePagesAvailable ? HugePageAdvice::Disabled : HugePageAdvice::None, generator);
+    std::cout << Indentation << std::setw(SizeWidth) << toByteSizeString(workingSetSize) << std::setw(ColumnWidth)
+              << toFixedPrecisionString(smallPages.nanoseconds, LatencyDecimalPlaces);
+    const auto metric = "Load latency in a " + toByteSizeString(workingSetSize) + " working set";
+    recordResult(metric + " of " + smallPagesName, smallPages.nanoseconds, "ns");
+    auto latency = smallPages.nanoseconds;
+    if (hugePagesAvailable) {
+      const auto hugePages = measureWorkingSetLatency(workingSetSize, HugePageAdvice::Enabled, generator);
+      std::cout << std::setw(ColumnWidth) << toFixedPrecisionString(hugePages.nanoseconds, LatencyDecimalPlaces) << std::setw(ColumnWidth - 1)
+                << toFixedPrecisionString(hugePages.hugePageFraction * 100.0, 0) << "%";
+      recordResult(metric + " of huge pages", hugePages.nanoseconds, "ns");
+      // Huge pages leave fewer translation misses to blur the transitions between cache levels.
+      latency = hugePages.nanoseconds;
+    }
+    std::cout << "\n";
+    workingSetSizes.push_back(workingSetSize);
+    latencies.push_back(latency);
+  }
+  if (hugePagesAvailable) {
+    std::cout << Indentation << "Where huge pages are faster, the difference is the cost of the TLB misses which small pages take.\n";
+  }
+  const auto plateaus = findLatencyPlateaus(latencies);
+  const auto reportedCacheSizes = getReportedCacheSizes();
+  // The last plateau is only main memory if the largest working set is well beyond every cache, as it may otherwise be the last level cache.
+  const auto reachesMainMemory =
+      plateaus.size() > 1 && (reportedCacheSizes.empty() || maximumWorkingSetSize >= 2 * reportedCacheSizes.back().size);
+  const auto cacheLevelCount = reachesMainMemory ? plateaus.size() - 1 : plateaus.size();
+  std::cout << Indentation << "The latency plateaus suggest:\n";
+  for (std::size_t level = 0; level < cacheLevelCount; level++) {
+    const auto &plateau = plateaus[level];
+    const auto latency = latencies[(plateau.firstIndex + plateau.lastIndex) / 2];
+    // Appending the number avoids a false -Wrestrict warning which GCC 12 gives for a string literal plus a temporary string.
+    std::string levelName = "L";
+    levelName += std::to_string(level + 1);
+    std::cout << Indentation << Indentation << levelName << ": at least " << toByteSizeString(workingSetSizes[plateau.lastIndex]) << ", "
+              << toFixedPrecisionString(latency, LatencyDecimalPlaces) << " ns per load\n";
+    recordResult(levelName + " latency", latency, "ns");
+  }
+  if (reachesMainMemory) {
+    const auto latency = latencies[plateaus.back().lastIndex];
+    std::cout << Indentation << Indentation << "Main memory: " << toFixedPrecisionString(latency, LatencyDecimalPlaces) << " ns per load\n";
+    recordResult("Main memory latency", latency, "ns");
+  } else {
+    std::cout << Indentation << "The largest working set may still fit in the last level cache, so raise --maximum-working-set";
+    if (!reportedCacheSizes.empty()) {
+      std::cout << " to at least " << toByteSizeString(2 * reportedCacheSizes.back().size);
+    }
+    std::cout << " to measure main memory.\n";
+  }
+  testCacheLineSize(generator);
+}
+} // namespace Experiments
@@ -0,0 +1,9 @@
+#pragma once
+
+namespace Experiments {
+/**
+ * Measures the latency of dependent loads which chase pointers through a random cycle over working sets from 1 KiB up to the maximum working set, with
+ * small pages and with transparent huge pages, and infers the capacity and latency of each cache level, the latency of main memory and the cache line size.
+ * */
+void testMemoryLatency();
+} // namespace Experiments
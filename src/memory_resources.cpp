@@ -0,0 +1,201 @@
+#include "memory_resources.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <memory_resource>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "experiment_runner.hpp"
+#include "formatting.hpp"
+#include "memory.hpp"
+#include "results.hpp"
+#include "timing.hpp"
+#include "types.hpp"
+
+namespace Experiments {
+namespace {
+enum class MemoryResourceKind { NewDelete, Monotonic, BufferedMonotonic, UnsynchronizedPool, SynchronizedPool };
+
+static constexpr std::array<MemoryResourceKind, 5> MemoryResourceKinds{MemoryResourceKind::NewDelete, MemoryResourceKind::Monotonic,
+                                                                       MemoryResourceKind::BufferedMonotonic, MemoryResourceKind::UnsynchronizedPool,
+                                                                       MemoryResourceKind::SynchronizedPool};
+
+/**
+ * The buffer of the buffered monotonic resource is allocated with the resource, so it is one call to operator new, as a buffer on the stack of a request
+ * handler would be none.
+ * */
+static constexpr std::size_t MonotonicBufferSize = 64 * 1024;
+
+[[nodiscard]] std::string_view getMemoryResourceName(const MemoryResourceKind kind) {
+  switch (kind) {
+  case MemoryResourceKind::NewDelete:
+    return "new_delete_resource";
+  case MemoryResourceKind::Monotonic:
+    return "monotonic_buffer_resource";
+  case MemoryResourceKind::BufferedMonotonic:
+    return "monotonic, 64 KiB buffer";
+  case MemoryResourceKind::UnsynchronizedPool:
+    return "unsynchronized_pool_resource";
+  case MemoryResourceKind::SynchronizedPool:
+    return "synchronized_pool_resource";
+  }
+  return "unknown";
+}
+
+/**
+ * Owns the memory resource a workload runs with.
+ * */
+class WorkloadMemoryResource {
+  std::unique_ptr<std::byte[]> buffer;
+  std::unique_ptr<std::pmr::memory_resource> ownedResource;
+  std::pmr::monotonic_buffer_resource *monotonicResource = nullptr;
+
+public:
+  explicit WorkloadMemoryResource(const MemoryResourceKind kind) {
+    switch (kind) {
+    case MemoryResourceKind::NewDelete:
+      break;
+    case MemoryResourceKind::Monotonic:
+      ownedResource = std::make_unique<std::pmr::monotonic_buffer_resource>();
+      break;
+    case MemoryResourceKind::BufferedMonotonic:
+      buffer = std::make_unique<std::byte[]>(MonotonicBufferSize);
+      ownedResource = std::make_unique<std::pmr::monotonic_buffer_resource>(buffer.get(), MonotonicBufferSize);
+      break;
+    case MemoryResourceKind::UnsynchronizedPool:
+      ownedResource = std::make_unique<std::pmr::unsynchronized_pool_resource>();
+      break;
+    case MemoryResourceKind::SynchronizedPool:
+      ownedResource = std::make_unique<std::pmr::synchronized_pool_resource>();
+      break;
+    }
+    monotonicResource = dynamic_cast<std::pmr::monotonic_buffer_resource *>(ownedResource.get());
+  }
+
+  [[nodiscard]] std::pmr::memory_resource *get() const noexcept { return ownedResource ? ownedResource.get() : std::pmr::new_delete_resource(); }
+
+  /**
+   * Ends a request, which frees everything a monotonic resource allocated during it, while the other resources reuse memory as soon as it is deallocated.
+   * */
+  void endRequest() {
+    if (monotonicResource != nullptr) {
+      monotonicResource->release();
+    }
+  }
+};
+
+struct MemoryResourceWorkload {
+  std::string name;
+  std::function<void(WorkloadMemoryResource &)> run;
+};
+
+struct WorkloadResult {
+  TimingStatistics timing;
+  std::size_t allocations;
+  std::size_t peakLiveBytes;
+};
+} // namespace
+
+static void buildUnorderedMap(WorkloadMemoryResource &resource) {
+  const auto elementCount = static_cast<int>(std::min<std::size_t>(1'000'000, getExperimentOptions().maximumElementCount));
+  std::pmr::unordered_map<int, int> map(resource.get());
+  for (int i = 0; i < elementCount; i++) {
+    map.emplace(i, i);
+  }
+}
+
+static void buildShortLivedStringVectors(WorkloadMemoryResource &resource) {
+  static constexpr std::size_t Requests = 10'000;
+  static constexpr std::size_t StringsPerRequest = 64;
+  // Longer than the small string optimization of the common standard libraries, so every string allocates.
+  static constexpr std::size_t StringLength = 40;
+  for (std::size_t i = 0; i < Requests; i++) {
+    {
+      std::pmr::vector<std::pmr::string> strings(resource.get());
+      for (std::size_t j = 0; j < StringsPerRequest; j++) {
+        strings.emplace_back(StringLength, 'A');
+      }
+    }
+    resource.endRequest();
+  }
+}
+
+/**
+ * Repeats the assignments of testVectorAssignment.
+ * */
+static void assignVectors(WorkloadMemoryResource &resource) {
+  static constexpr std::size_t Requests = 10'000;
+  static constexpr std::array<std::size_t, 3> Sizes{10, 100, 1000};
+  for (std::size_t i = 0; i < Requests; i++) {
+    for (const auto lhsSize : Sizes) {
+      for (const auto rhsSize : Sizes) {
+        std::pmr::vector<U8> lhs(lhsSize, resource.get());
+        const std::pmr::vector<U8> rhs(rhsSize, resource.get());
+        lhs = rhs;
+      }
+    }
+    resource.endRequest();
+  }
+}
+
+/**
+ * Times the workload without tracking allocations, which would slow it down, and then runs it once more to count its allocations.
+ * */
+static WorkloadResult measureWorkload(const MemoryResourceWorkload &workload, const MemoryResourceKind kind) {
+  static constexpr std::size_t Repetitions = 3;
+  WorkloadResult result{};
+  // Creating and destroying the resource is timed, as monotonic resources only free their memory when they are destroyed.
+  result.timing = measureRepeatedly(
+      Repetitions, []() {},
+      [&workload, kind]() {
+        WorkloadMemoryResource resource(kind);
+        workload.run(resource);
+      });
+  AllocationTrackerGuard allocationTrackerGuard(false, false, false, true);
+  {
+    WorkloadMemoryResource trackedResource(kind);
+    workload.run(trackedResource);
+  }
+  const auto statistics = allocationTrackerGuard.getStatistics();
+  result.allocations = statistics.allocations;
+  result.peakLiveBytes = statistics.peakLiveBytes;
+  return result;
+}
+
+void testMemoryResources() {
+  static constexpr int NameWidth = 30;
+  static constexpr int ColumnWidth = 16;
+  const std::array<MemoryResourceWorkload, 3> workloads{
+      MemoryResourceWorkload{"Building an unordered_map<int, int> of " + toStringWithThousandsSeparators(std::min<std::size_t>(
+                                                                              1'000'000, getExperimentOptions().maximumElementCount)) +
+                                 " entries",
+                             buildUnorderedMap},
+      MemoryResourceWorkload{"Building 10,000 short-lived vectors of 64 strings of 40 characters, one per request", buildShortLivedStringVectors},
+      MemoryResourceWorkload{"Assigning vectors of 10, 100 and 1,000 bytes to each other 10,000 times, one request each time", assignVectors}};
+  std::cout << "Testing workloads with the memory resources of std::pmr.\n";
+  std::cout << Indentation << "Monotonic resources are released at the end of every request, and include the memory they allocate up front.\n";
+  for (const auto &workload : workloads) {
+    std::cout << Indentation << workload.name << ":\n";
+    std::cout << Indentation << Indentation << std::setw(NameWidth) << std::left << "" << std::right << std::setw(ColumnWidth) << "Median time"
+              << std::setw(ColumnWidth) << "Allocations" << std::setw(ColumnWidth) << "Peak bytes" << "\n";
+    for (const auto kind : MemoryResourceKinds) {
+      const auto result = measureWorkload(workload, kind);
+      std::cout << Indentation << Indentation << std::setw(NameWidth) << std::left << getMemoryResourceName(kind) << std::right << std::setw(ColumnWidth)
+                << toDurationString(result.timing.median) << std::setw(ColumnWidth) << toStringWithThousandsSeparators(result.allocations)
+                << std::setw(ColumnWidth) << toStringWithThousandsSeparators(result.peakLiveBytes) << "\n";
+      const auto metric = workload.name + " with " + std::string(getMemoryResourceName(kind));
+      recordResult(metric, result.timing.median, "s");
+      recordResult(metric + ", allocations", static_cast<double>(result.allocations), "allocations");
+      recordResult(metric + ", peak bytes", static_cast<double>(result.peakLiveBytes), "bytes");
+    }
+  }
+}
+} // namespace Experiments
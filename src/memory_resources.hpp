@@ -0,0 +1,9 @@
+#pragma once
+
+namespace Experiments {
+/**
+ * Runs workloads with the default memory resource and with the monotonic and pool resources of std::pmr, and reports their duration, their calls to the
+ * global operator new and their peak of live bytes.
+ * */
+void testMemoryResources();
+} // namespace Experiments
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstddef>
+
+#include "types.hpp"
+
+namespace Experiments {
+/**
+ * Copies with 32-byte AVX non-temporal stores, which write around the caches instead of first reading every destination line into them, and so neither
+ * spend read bandwidth on the destination nor evict the data which was in the caches.
+ *
+ * Only call this if the processor supports AVX.
+ * */
+void copyWithNonTemporalStores(U8 *destination, const U8 *source, std::size_t size) noexcept;
+} // namespace Experiments
@@ -0,0 +1,30 @@
+#include <immintrin.h>
+
+#include <cstdint>
+
+#include "non_temporal_copy.hpp"
+
+// This translation unit is compiled for AVX, so it must not define or instantiate anything the linker could pick over a copy compiled without it.
+namespace Experiments {
+void copyWithNonTemporalStores(U8 *const destination, const U8 *const source, const std::size_t size) noexcept {
+  static constexpr std::size_t VectorSize = sizeof(__m256i);
+  // Non-temporal stores must be aligned, so the bytes up to the first aligned address of the destination are copied one at a time.
+  const auto misalignment = reinterpret_cast<std::uintptr_t>(destination) % VectorSize;
+  auto head = misalignment == 0 ? 0 : VectorSize - misalignment;
+  if (head > size) {
+    head = size;
+  }
+  std::size_t i = 0;
+  for (; i < head; i++) {
+    destination[i] = source[i];
+  }
+  for (; i + VectorSize <= size; i += VectorSize) {
+    _mm256_stream_si256(reinterpret_cast<__m256i *>(destination + i), _mm256_loadu_si256(reinterpret_cast<const __m256i *>(source + i)));
+  }
+  for (; i < size; i++) {
+    destination[i] = source[i];
+  }
+  // Non-temporal stores are weakly ordered, so they are fenced before the caller can read the destination or hand it to another thread.
+  _mm_sfence();
+}
+} // namespace Experiments
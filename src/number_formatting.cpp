@@ -0,0 +1,246 @@
+#include "number_formatting.hpp"
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cinttypes>
+#include <cstddef>
+#include <cstdio>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <locale>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <version>
+
+#ifdef __cpp_lib_format
+#include <format>
+#endif
+
+#include "experiment_runner.hpp"
+#include "formatting.hpp"
+#include "memory.hpp"
+#include "results.hpp"
+#include "timing.hpp"
+#include "types.hpp"
+
+namespace Experiments {
+namespace {
+struct FormattingMethod {
+  std::string_view name;
+  /**
+   * Formats every number and returns the number of characters written, so that the formatting cannot be optimized away.
+   * */
+  std::function<std::size_t()> formatAll;
+  /**
+   * Returns the characters written for the number at the index, so that the methods of a kind can be checked against each other.
+   * */
+  std::function<std::string(std::size_t index)> format;
+};
+
+struct FormattingKind {
+  std::string_view name;
+  std::vector<FormattingMethod> methods;
+};
+
+class WithThousandsSeparators : public std::numpunct<char> {
+protected:
+  char do_thousands_sep() const override { return ','; }
+  std::string do_grouping() const override { return "\03"; }
+};
+} // namespace
+
+static constexpr U32 FormattedDecimalPlaces = 3;
+static constexpr std::size_t FormattingBufferSize = 64;
+
+using FormattingBuffer = std::array<char, FormattingBufferSize>;
+
+/**
+ * Numbers which the methods are the most likely to format differently, which replace the first of the random numbers.
+ * */
+static constexpr std::array<U64, 2> EdgeCaseIntegers{0, std::numeric_limits<U64>::max()};
+static constexpr std::array<double, 5> EdgeCaseDoubles{0.0, -0.0, -0.0004, 0.0005, -999'999.9995};
+
+/**
+ * Integers of every magnitude, as a uniform distribution over U64 would almost only produce numbers of 19 or 20 digits.
+ * */
+static std::vector<U64> makeFormattedIntegers(const std::size_t count) {
+  std::mt19937_64 generator(count);
+  std::vector<U64> integers(count);
+  for (auto &integer : integers) {
+    integer = generator() >> (generator() % 64);
+  }
+  std::copy_n(std::begin(EdgeCaseIntegers), std::min(count, EdgeCaseIntegers.size()), std::begin(integers));
+  return integers;
+}
+
+static std::vector<double> makeFormattedDoubles(const std::size_t count) {
+  std::mt19937_64 generator(count);
+  std::uniform_real_distribution<double> distribution(-1e6, 1e6);
+  std::vector<double> doubles(count);
+  for (auto &value : doubles) {
+    value = distribution(generator);
+  }
+  std::copy_n(std::begin(EdgeCaseDoubles), std::min(count, EdgeCaseDoubles.size()), std::begin(doubles));
+  return doubles;
+}
+
+/**
+ * Inserts the separators into the digits written by snprintf, as the thousands separator flag of printf depends on the global C locale.
+ * */
+static std::size_t snprintfWithThousandsSeparators(char *const buffer, const U64 value) {
+  FormattingBuffer digits{};
+  const auto digitCount = static_cast<std::size_t>(std::snprintf(digits.data(), digits.size(), "%" PRIu64, value));
+  std::size_t length = 0;
+  for (std::size_t i = 0; i < digitCount; i++) {
+    if (i > 0 && (digitCount - i) % 3 == 0) {
+      buffer[length++] = ',';
+    }
+    buffer[length++] = digits[i];
+  }
+  return length;
+}
+
+/**
+ * The function writes a number into a buffer of FormattingBufferSize characters and returns how many it wrote.
+ * */
+template <typename T, typename Function>
+static FormattingMethod makeFormattingMethod(const std::string_view name, const std::vector<T> &values, Function function) {
+  return {name,
+          [&values, function]() {
+            FormattingBuffer buffer{};
+            std::size_t characters = 0;
+            for (const auto value : values) {
+              characters += function(buffer.data(), value);
+            }
+            return characters;
+          },
+          [&values, function](const std::size_t index) {
+            FormattingBuffer buffer{};
+            return std::string(buffer.data(), function(buffer.data(), values[index]));
+          }};
+}
+
+[[nodiscard]] static std::size_t copyToBuffer(const std::string &string, char *const buffer) { return string.copy(buffer, FormattingBufferSize); }
+
+static std::vector<FormattingKind> makeFormattingKinds(const std::vector<U64> &integers, const std::vector<double> &doubles) {
+  std::vector<FormattingKind> kinds;
+  kinds.push_back({"Integers",
+                   {makeFormattingMethod("std::ostringstream", integers,
+                                         [](char *const buffer, const U64 value) {
+                                           std::ostringstream stream;
+                                           stream << value;
+                                           return copyToBuffer(stream.str(), buffer);
+                                         }),
+                    makeFormattingMethod("std::snprintf", integers,
+                                         [](char *const buffer, const U64 value) {
+                                           return static_cast<std::size_t>(std::snprintf(buffer, FormattingBufferSize, "%" PRIu64, value));
+                                         }),
+                    makeFormattingMethod("std::to_chars", integers, [](char *const buffer, const U64 value) {
+                      return static_cast<std::size_t>(std::to_chars(buffer, buffer + FormattingBufferSize, value).ptr - buffer);
+                    })}});
+  kinds.push_back({"Integers with thousands separators",
+                   {makeFormattingMethod("std::ostringstream, new locale", integers,
+                                         [](char *const buffer, const U64 value) {
+                                           std::ostringstream stream;
+                                           stream.imbue(std::locale(std::locale::classic(), new WithThousandsSeparators));
+                                           stream << value;
+                                           return copyToBuffer(stream.str(), buffer);
+                                         }),
+                    makeFormattingMethod("std::snprintf", integers, snprintfWithThousandsSeparators),
+                    makeFormattingMethod("toCharsWithThousandsSeparators", integers,
+                                         [](char *const buffer, const U64 value) {
+                                           const auto end = toCharsWithThousandsSeparators(buffer, buffer + FormattingBufferSize, value).ptr;
+                                           return static_cast<std::size_t>(end - buffer);
+                                         }),
+                    makeFormattingMethod("toStringWithThousandsSeparators", integers, [](char *const buffer, const U64 value) {
+                      return copyToBuffer(toStringWithThousandsSeparators(value), buffer);
+                    })}});
+  kinds.push_back({"Doubles with 3 decimal places",
+                   {makeFormattingMethod("std::ostringstream", doubles,
+                                         [](char *const buffer, const double value) {
+                                           std::ostringstream stream;
+                                           stream << std::fixed << std::setprecision(FormattedDecimalPlaces) << value;
+                                           return copyToBuffer(stream.str(), buffer);
+                                         }),
+                    makeFormattingMethod("std::snprintf", doubles,
+                                         [](char *const buffer, const double value) {
+                                           return static_cast<std::size_t>(std::snprintf(buffer, FormattingBufferSize, "%.*f", FormattedDecimalPlaces, value));
+                                         }),
+                    makeFormattingMethod("toCharsWithFixedPrecision", doubles,
+                                         [](char *const buffer, const double value) {
+                                           const auto end = toCharsWithFixedPrecision(buffer, buffer + FormattingBufferSize, value, FormattedDecimalPlaces).ptr;
+                                           return static_cast<std::size_t>(end - buffer);
+                                         }),
+                    makeFormattingMethod("toFixedPrecisionString", doubles, [](char *const buffer, const double value) {
+                      return copyToBuffer(toFixedPrecisionString(value, FormattedDecimalPlaces), buffer);
+                    })}});
+#ifdef __cpp_lib_format
+  kinds[0].methods.push_back(makeFormattingMethod("std::format_to", integers, [](char *const buffer, const U64 value) {
+    return static_cast<std::size_t>(std::format_to(buffer, "{}", value) - buffer);
+  }));
+  kinds[2].methods.push_back(makeFormattingMethod("std::format_to", doubles, [](char *const buffer, const double value) {
+    return static_cast<std::size_t>(std::format_to(buffer, "{:.3f}", value) - buffer);
+  }));
+#endif
+  return kinds;
+}
+
+/**
+ * Throws std::logic_error if a method of the kind does not format every number as the first method does.
+ * */
+static void checkFormattingMethodsAgree(const FormattingKind &kind, const std::size_t count) {
+  for (std::size_t i = 0; i < count; i++) {
+    const auto expected = kind.methods.front().format(i);
+    for (const auto &method : kind.methods) {
+      if (const auto formatted = method.format(i); formatted != expected) {
+        throw std::logic_error(std::string(method.name) + " formatted \"" + formatted + "\" instead of \"" + expected + "\" in " + std::string(kind.name) +
+                               ".");
+      }
+    }
+  }
+}
+
+void testNumberFormattingThroughput() {
+  static constexpr std::size_t Repetitions = 3;
+  static constexpr int MethodNameWidth = 36;
+  static constexpr int ColumnWidth = 20;
+  static constexpr U32 ThroughputDecimalPlaces = 2;
+  const auto count = std::min<std::size_t>(1'000'000, getExperimentOptions().maximumElementCount);
+  const auto integers = makeFormattedIntegers(count);
+  const auto doubles = makeFormattedDoubles(count);
+  std::cout << "Testing the throughput of formatting " << toStringWithThousandsSeparators(count) << " numbers, which every method of a kind formats alike.\n";
+#ifndef __cpp_lib_format
+  std::cout << Indentation << "This standard library does not have std::format.\n";
+#endif
+  for (const auto &kind : makeFormattingKinds(integers, doubles)) {
+    checkFormattingMethodsAgree(kind, count);
+    std::cout << Indentation << kind.name << ":\n";
+    std::cout << Indentation << Indentation << std::setw(MethodNameWidth) << "" << std::setw(ColumnWidth) << "M numbers/s" << std::setw(ColumnWidth)
+              << "Allocations/number" << "\n";
+    for (const auto &method : kind.methods) {
+      std::size_t characters = 0;
+      const auto timing = measureRepeatedly(
+          Repetitions, []() {}, [&method, &characters]() { characters = method.formatAll(); });
+      preventOptimization(characters);
+      AllocationTrackerGuard allocationTrackerGuard(false, false, false, false);
+      characters = method.formatAll();
+      const auto allocations = allocationTrackerGuard.getAllocationsMade();
+      const auto millionsOfNumbersPerSecond = static_cast<double>(count) / timing.median / 1e6;
+      const auto allocationsPerNumber = static_cast<double>(allocations) / static_cast<double>(count);
+      const auto metric = std::string(kind.name) + ", " + std::string(method.name);
+      recordResult(metric, millionsOfNumbersPerSecond, "M numbers/s", MetricDirection::HigherIsBetter);
+      recordResult(metric + ", allocations", allocationsPerNumber, "allocations/number");
+      std::cout << Indentation << Indentation << std::setw(MethodNameWidth) << std::left << method.name << std::right << std::setw(ColumnWidth)
+                << toFixedPrecisionString(millionsOfNumbersPerSecond, ThroughputDecimalPlaces) << std::setw(ColumnWidth)
+                << toFixedPrecisionString(allocationsPerNumber, ThroughputDecimalPlaces) << "\n";
+    }
+  }
+}
+} // namespace Experiments
@@ -0,0 +1,9 @@
+#pragma once
+
+namespace Experiments {
+/**
+ * Compares formatting integers, integers with thousands separators and doubles with fixed precision through iostreams, snprintf, std::to_chars and
+ * std::format, if the standard library has it, reporting their throughput and their allocations per number.
+ * */
+void testNumberFormattingThroughput();
+} // namespace Experiments
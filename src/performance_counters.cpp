@@ -0,0 +1,172 @@
+#include "performance_counters.hpp"
+
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "formatting.hpp"
+
+namespace Experiments {
+namespace {
+struct HardwareCounter {
+  std::string_view name;
+  U32 type;
+  U64 config;
+};
+} // namespace
+
+[[nodiscard]] static constexpr U64 makeCacheEventConfig(const U64 cache, const U64 operation, const U64 result) noexcept {
+  return cache | (operation << 8u) | (result << 16u);
+}
+
+static constexpr std::array<HardwareCounter, 6> HardwareCounters{{
+    {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {"L1 data cache read misses", PERF_TYPE_HW_CACHE,
+     makeCacheEventConfig(PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS)},
+    {"last level cache read misses", PERF_TYPE_HW_CACHE,
+     makeCacheEventConfig(PERF_COUNT_HW_CACHE_LL, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS)},
+    {"branch misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    {"data TLB read misses", PERF_TYPE_HW_CACHE,
+     makeCacheEventConfig(PERF_COUNT_HW_CACHE_DTLB, PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS)},
+}};
+
+static constexpr int UnavailableCounter = -1;
+
+[[nodiscard]] static int openHardwareCounter(const HardwareCounter &counter) noexcept {
+  perf_event_attr attributes{};
+  attributes.size = sizeof(attributes);
+  attributes.type = counter.type;
+  attributes.config = counter.config;
+  attributes.disabled = 1;
+  attributes.inherit = 1;
+  // Counting only user space is what unprivileged processes are usually permitted to do.
+  attributes.exclude_kernel = 1;
+  attributes.exclude_hv = 1;
+  attributes.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+  return static_cast<int>(syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0));
+}
+
+static void getPageFaults(U64 &minorPageFaults, U64 &majorPageFaults) noexcept {
+  rusage usage{};
+  getrusage(RUSAGE_SELF, &usage);
+  minorPageFaults = static_cast<U64>(usage.ru_minflt);
+  majorPageFaults = static_cast<U64>(usage.ru_majflt);
+}
+
+PerformanceCounters::PerformanceCounters() {
+  fileDescriptors.reserve(HardwareCounters.size());
+  for (const auto &counter : HardwareCounters) {
+    const auto fileDescriptor = openHardwareCounter(counter);
+    if (fileDescriptor == UnavailableCounter && unavailabilityReason.empty()) {
+      unavailabilityReason = std::strerror(errno);
+    }
+    fileDescriptors.push_back(fileDescriptor);
+  }
+}
+
+bool PerformanceCounters::hasHardwareCounters() const noexcept {
+  for (const auto fileDescriptor : fileDescriptors) {
+    if (fileDescriptor != UnavailableCounter) {
+      return true;
+    }
+  }
+  return false;
+}
+
+const std::string &PerformanceCounters::getUnavailabilityReason() const noexcept { return unavailabilityReason; }
+
+void PerformanceCounters::start() {
+  for (const auto fileDescriptor : fileDescriptors) {
+    if (fileDescriptor != UnavailableCounter) {
+      ioctl(fileDescriptor, PERF_EVENT_IOC_RESET, 0);
+    }
+  }
+  getPageFaults(minorPageFaultsAtStart, majorPageFaultsAtStart);
+  for (const auto fileDescriptor : fileDescriptors) {
+    if (fileDescriptor != UnavailableCounter) {
+      ioctl(fileDescriptor, PERF_EVENT_IOC_ENABLE, 0);
+    }
+  }
+}
+
+void PerformanceCounters::stop() {
+  for (const auto fileDescriptor : fileDescriptors) {
+    if (fileDescriptor != UnavailableCounter) {
+      ioctl(fileDescriptor, PERF_EVENT_IOC_DISABLE, 0);
+    }
+  }
+  getPageFaults(minorPageFaults, majorPageFaults);
+  minorPageFaults -= minorPageFaultsAtStart;
+  majorPageFaults -= majorPageFaultsAtStart;
+}
+
+std::vector<PerformanceCounterReading> PerformanceCounters::read() const {
+  std::vector<PerformanceCounterReading> readings;
+  for (std::size_t i = 0; i < HardwareCounters.size(); i++) {
+    auto &reading = readings.emplace_back(PerformanceCounterReading{HardwareCounters[i].name, std::nullopt});
+    if (fileDescriptors[i] == UnavailableCounter) {
+      continue;
+    }
+    // The value, the time the counter was enabled, and the time it was actually counting.
+    std::array<U64, 3> values{};
+    if (::read(fileDescriptors[i], values.data(), sizeof(values)) != static_cast<ssize_t>(sizeof(values))) {
+      continue;
+    }
+    const auto [value, timeEnabled, timeRunning] = values;
+    if (timeRunning == 0) {
+      reading.value = 0;
+    } else if (timeRunning < timeEnabled) {
+      reading.value = static_cast<U64>(static_cast<double>(value) * static_cast<double>(timeEnabled) / static_cast<double>(timeRunning));
+    } else {
+      reading.value = value;
+    }
+  }
+  readings.push_back({"minor page faults", minorPageFaults});
+  readings.push_back({"major page faults", majorPageFaults});
+  return readings;
+}
+
+PerformanceCounters::~PerformanceCounters() {
+  for (const auto fileDescriptor : fileDescriptors) {
+    if (fileDescriptor != UnavailableCounter) {
+      close(fileDescriptor);
+    }
+  }
+}
+
+static void printIndentation(const std::size_t indentationLevel) {
+  for (std::size_t i = 0; i < indentationLevel; i++) {
+    std::cout << Indentation;
+  }
+}
+
+void printPerformanceCounterReadings(const std::vector<PerformanceCounterReading> &readings, const std::size_t indentationLevel) {
+  std::optional<U64> cycles;
+  std::optional<U64> instructions;
+  for (const auto &reading : readings) {
+    if (!reading.value) {
+      continue;
+    }
+    printIndentation(indentationLevel);
+    std::cout << reading.name << ": " << toStringWithThousandsSeparators(*reading.value) << "\n";
+    if (reading.name == "cycles") {
+      cycles = reading.value;
+    } else if (reading.name == "instructions") {
+      instructions = reading.value;
+    }
+  }
+  if (cycles && instructions && *cycles != 0) {
+    const auto instructionsPerCycle = static_cast<double>(*instructions) / static_cast<double>(*cycles);
+    printIndentation(indentationLevel);
+    std::cout << "instructions per cycle: " << toFixedPrecisionString(instructionsPerCycle, 2) << "\n";
+  }
+}
+} // namespace Experiments
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "types.hpp"
+
+namespace Experiments {
+struct PerformanceCounterReading {
+  std::string_view name;
+  /**
+   * Empty if the counter could not be opened, which is common in containers and virtual machines.
+   * */
+  std::optional<U64> value;
+};
+
+/**
+ * Counts hardware events of this process, including threads it creates while counting, through perf_event_open, and page faults through getrusage.
+ *
+ * Counters which the kernel does not permit or the machine does not have are reported as unavailable instead of failing, and the page faults are always
+ * available. Counters are scaled if the kernel had to multiplex them.
+ * */
+class PerformanceCounters {
+  std::vector<int> fileDescriptors;
+  std::string unavailabilityReason;
+  U64 minorPageFaultsAtStart = 0;
+  U64 majorPageFaultsAtStart = 0;
+  U64 minorPageFaults = 0;
+  U64 majorPageFaults = 0;
+
+public:
+  PerformanceCounters();
+
+  PerformanceCounters(const PerformanceCounters &) = delete;
+
+  PerformanceCounters &operator=(const PerformanceCounters &) = delete;
+
+  /**
+   * Returns whether any hardware counter could be opened.
+   * */
+  [[nodiscard]] bool hasHardwareCounters() const noexcept;
+
+  /**
+   * Returns why the hardware counters which could not be opened were refused, or an empty string if all could be opened.
+   * */
+  [[nodiscard]] const std::string &getUnavailabilityReason() const noexcept;
+
+  /**
+   * Resets and starts all counters.
+   * */
+  void start();
+
+  void stop();
+
+  /**
+   * Reads the counters, which should have been stopped.
+   * */
+  [[nodiscard]] std::vector<PerformanceCounterReading> read() const;
+
+  ~PerformanceCounters();
+};
+
+/**
+ * Only prints the readings of available counters.
+ * */
+void printPerformanceCounterReadings(const std::vector<PerformanceCounterReading> &readings, std::size_t indentationLevel = 1);
+} // namespace Experiments
@@ -0,0 +1,174 @@
+#include "queue_handoff.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <iomanip>
+#include <iostream>
+#include <latch>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "concurrent_queues.hpp"
+#include "experiment_runner.hpp"
+#include "formatting.hpp"
+#include "memory.hpp"
+#include "results.hpp"
+#include "types.hpp"
+
+namespace Experiments {
+namespace {
+struct HandoffShape {
+  std::string name;
+  std::size_t producers;
+  std::size_t consumers;
+};
+
+struct HandoffResult {
+  double messagesPerSecond;
+  /**
+   * Latencies are in seconds.
+   * */
+  double medianLatency;
+  double p99Latency;
+  std::size_t allocations;
+};
+} // namespace
+
+static constexpr std::size_t QueueCapacity = 1024;
+
+/**
+ * Messages carry the time at which they were pushed, in nanoseconds since the epoch of std::chrono::steady_clock.
+ * */
+using Message = U64;
+
+static U64 getNanosecondsSinceEpoch() {
+  return static_cast<U64>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+static double getPercentile(std::vector<U64> &values, const double percentile) {
+  const auto index = static_cast<std::size_t>(percentile * static_cast<double>(values.size() - 1));
+  std::nth_element(values.begin(), values.begin() + static_cast<std::ptrdiff_t>(index), values.end());
+  return static_cast<double>(values[index]) / 1e9;
+}
+
+/**
+ * Every producer pushes and every consumer pops the same number of messages, yielding whenever the queue is full or empty so that the threads also make
+ * progress when there are fewer hardware threads than threads.
+ *
+ * Allocations are only tracked from when all threads have started until they have all finished, which is the steady state of a pipeline. The latencies are
+ * recorded into vectors reserved beforehand, so recording them does not allocate either.
+ *
+ * Throws std::logic_error if a queue other than LockedQueue, whose std::deque allocates blocks, allocates while handing off.
+ * */
+template <typename Queue> static HandoffResult measureHandoff(const HandoffShape &shape, const std::size_t messageCount) {
+  Queue queue(QueueCapacity);
+  const auto messagesPerProducer = messageCount / shape.producers;
+  const auto messagesPerConsumer = messageCount / shape.consumers;
+  std::vector<std::vector<U64>> latencies(shape.consumers);
+  for (auto &consumerLatencies : latencies) {
+    consumerLatencies.reserve(messagesPerConsumer);
+  }
+  const auto threadCount = static_cast<std::ptrdiff_t>(shape.producers + shape.consumers);
+  std::latch started(threadCount + 1);
+  std::latch released(1);
+  std::latch finished(threadCount);
+  std::optional<AllocationTrackerGuard> allocationTrackerGuard;
+  std::chrono::steady_clock::time_point start;
+  std::chrono::steady_clock::time_point end;
+  HandoffResult result{};
+  {
+    std::vector<std::jthread> threads;
+    threads.reserve(shape.producers + shape.consumers);
+    for (std::size_t i = 0; i < shape.producers; i++) {
+      threads.emplace_back([&]() {
+        started.count_down();
+        released.wait();
+        for (std::size_t j = 0; j < messagesPerProducer; j++) {
+          while (!queue.tryPush(getNanosecondsSinceEpoch())) {
+            std::this_thread::yield();
+          }
+        }
+        finished.count_down();
+      });
+    }
+    for (std::size_t i = 0; i < shape.consumers; i++) {
+      threads.emplace_back([&, i]() {
+        started.count_down();
+        released.wait();
+        Message message{};
+        for (std::size_t j = 0; j < messagesPerConsumer; j++) {
+          while (!queue.tryPop(message)) {
+            std::this_thread::yield();
+          }
+          latencies[i].push_back(getNanosecondsSinceEpoch() - message);
+        }
+        finished.count_down();
+      });
+    }
+    started.arrive_and_wait();
+    allocationTrackerGuard.emplace(false, false, false, false);
+    start = std::chrono::steady_clock::now();
+    released.count_down();
+    finished.wait();
+    end = std::chrono::steady_clock::now();
+    result.allocations = allocationTrackerGuard->getAllocationsMade();
+  }
+  if constexpr (!std::is_same_v<Queue, LockedQueue<Message>>) {
+    if (result.allocations != 0) {
+      throw std::logic_error("A lock-free queue made " + pluralizeAsNeeded(result.allocations, "allocation") + " while handing off messages.");
+    }
+  }
+  std::vector<U64> allLatencies;
+  for (const auto &consumerLatencies : latencies) {
+    allLatencies.insert(allLatencies.end(), consumerLatencies.begin(), consumerLatencies.end());
+  }
+  result.messagesPerSecond = static_cast<double>(messageCount) / std::chrono::duration<double>(end - start).count();
+  result.medianLatency = getPercentile(allLatencies, 0.5);
+  result.p99Latency = getPercentile(allLatencies, 0.99);
+  return result;
+}
+
+void testConcurrentQueueHandoff() {
+  static constexpr int QueueNameWidth = 24;
+  static constexpr int ColumnWidth = 16;
+  static constexpr U32 ThroughputDecimalPlaces = 2;
+  const auto hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+  const auto sideThreads = std::max<std::size_t>(2, hardwareThreads / 2);
+  const std::vector<HandoffShape> shapes{{"1 producer, 1 consumer", 1, 1},
+                                         {std::to_string(sideThreads) + " producers, 1 consumer", sideThreads, 1},
+                                         {std::to_string(sideThreads) + " producers, " + std::to_string(sideThreads) + " consumers", sideThreads, sideThreads}};
+  std::cout << "Testing the handoff of messages between threads through bounded queues of " << QueueCapacity << " messages.\n";
+  std::cout << Indentation << "This machine runs " << pluralizeAsNeeded(hardwareThreads, "hardware thread") << ".\n";
+  for (const auto &shape : shapes) {
+    // Every thread handles the same number of messages.
+    const auto threadProduct = shape.producers * shape.consumers;
+    const auto requestedMessageCount = std::min<std::size_t>(1'000'000, getExperimentOptions().maximumElementCount);
+    const auto messageCount = std::max(threadProduct, requestedMessageCount / threadProduct * threadProduct);
+    std::cout << Indentation << shape.name << ", " << toStringWithThousandsSeparators(messageCount) << " messages:\n";
+    std::cout << Indentation << Indentation << std::setw(QueueNameWidth) << std::left << "" << std::right << std::setw(ColumnWidth) << "M messages/s"
+              << std::setw(ColumnWidth) << "p50 latency" << std::setw(ColumnWidth) << "p99 latency" << std::setw(ColumnWidth) << "Allocations" << "\n";
+    const auto printResult = [&shape](const std::string_view queueName, const HandoffResult &result) {
+      std::cout << Indentation << Indentation << std::setw(QueueNameWidth) << std::left << queueName << std::right << std::setw(ColumnWidth)
+                << toFixedPrecisionString(result.messagesPerSecond / 1e6, ThroughputDecimalPlaces) << std::setw(ColumnWidth)
+                << toDurationString(result.medianLatency) << std::setw(ColumnWidth) << toDurationString(result.p99Latency) << std::setw(ColumnWidth)
+                << toStringWithThousandsSeparators(result.allocations) << "\n";
+      const auto metric = std::string(queueName) + ", " + shape.name;
+      recordResult(metric, result.messagesPerSecond / 1e6, "M messages/s", MetricDirection::HigherIsBetter);
+      recordResult(metric + ", p50 latency", result.medianLatency, "s");
+      recordResult(metric + ", p99 latency", result.p99Latency, "s");
+      recordResult(metric + ", allocations", static_cast<double>(result.allocations), "allocations");
+    };
+    printResult("mutex and std::deque", measureHandoff<LockedQueue<Message>>(shape, messageCount));
+    printResult("lock-free MPMC", measureHandoff<BoundedMpmcQueue<Message>>(shape, messageCount));
+    if (shape.producers == 1 && shape.consumers == 1) {
+      printResult("lock-free SPSC", measureHandoff<BoundedSpscQueue<Message>>(shape, messageCount));
+    }
+  }
+}
+} // namespace Experiments
@@ -0,0 +1,9 @@
+#pragma once
+
+namespace Experiments {
+/**
+ * Hands messages from producer threads to consumer threads through the lock-free queues and through a locked std::deque, and reports their throughput, the
+ * latency from pushing a message to popping it, and the allocations made while the threads exchange messages.
+ * */
+void testConcurrentQueueHandoff();
+} // namespace Experiments
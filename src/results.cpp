@@ -0,0 +1,337 @@
+#include "results.hpp"
+
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include <boost/property_tree/json_parser.hpp>
+#include <boost/property_tree/ptree.hpp>
+
+#include "formatting.hpp"
+#include "types.hpp"
+
+namespace Experiments {
+static std::mutex activeResultRecorderMutex;
+static ResultRecorder *activeResultRecorder = nullptr;
+
+void recordResult(const std::string_view metric, const double value, const std::string_view unit, const MetricDirection direction) {
+  if (!std::isfinite(value)) {
+    return;
+  }
+  const std::scoped_lock lock(activeResultRecorderMutex);
+  if (activeResultRecorder != nullptr) {
+    activeResultRecorder->records.push_back({activeResultRecorder->experimentName, std::string(metric), value, std::string(unit), direction});
+  }
+}
+
+ResultRecorder::ResultRecorder(std::string experiment) : experimentName(std::move(experiment)) {
+  const std::scoped_lock lock(activeResultRecorderMutex);
+  activeResultRecorder = this;
+}
+
+std::vector<ResultRecord> ResultRecorder::takeRecords() {
+  const std::scoped_lock lock(activeResultRecorderMutex);
+  return std::exchange(records, {});
+}
+
+ResultRecorder::~ResultRecorder() {
+  const std::scoped_lock lock(activeResultRecorderMutex);
+  activeResultRecorder = nullptr;
+}
+
+ResultFormat getResultFormat(const std::filesystem::path &path) {
+  if (path.extension() == ".json") {
+    return ResultFormat::Json;
+  }
+  if (path.extension() == ".csv") {
+    return ResultFormat::Csv;
+  }
+  throw std::invalid_argument("Results files must end in .json or .csv, but got \"" + path.string() + "\".");
+}
+
+[[nodiscard]] static std::string_view getMetricDirectionName(const MetricDirection direction) {
+  switch (direction) {
+  case MetricDirection::LowerIsBetter:
+    return "lower-is-better";
+  case MetricDirection::HigherIsBetter:
+    return "higher-is-better";
+  case MetricDirection::Exact:
+    return "exact";
+  }
+  return "";
+}
+
+[[nodiscard]] static MetricDirection parseMetricDirection(const std::string_view name) {
+  for (const auto direction : {MetricDirection::LowerIsBetter, MetricDirection::HigherIsBetter, MetricDirection::Exact}) {
+    if (name == getMetricDirectionName(direction)) {
+      return direction;
+    }
+  }
+  throw std::runtime_error("Unknown metric direction \"" + std::string(name) + "\".");
+}
+
+/**
+ * Writes the shortest representation which reads back as the same double.
+ * */
+[[nodiscard]] static std::string toRoundTripString(const double value) {
+  std::array<char, 32> buffer{};
+  return {buffer.data(), std::to_chars(buffer.data(), buffer.data() + buffer.size(), value).ptr};
+}
+
+[[nodiscard]] static double parseValue(const std::string_view string) {
+  double value = 0.0;
+  const auto [end, error] = std::from_chars(string.data(), string.data() + string.size(), value);
+  if (error != std::errc{} || end != string.data() + string.size()) {
+    throw std::runtime_error("Expected a number, but got \"" + std::string(string) + "\".");
+  }
+  return value;
+}
+
+static void writeJsonString(std::ostream &stream, const std::string_view string) {
+  static constexpr std::string_view HexadecimalDigits = "0123456789abcdef";
+  stream << '"';
+  for (const auto character : string) {
+    if (character == '"' || character == '\\') {
+      stream << '\\' << character;
+    } else if (static_cast<unsigned char>(character) < 0x20u) {
+      stream << "\\u00" << HexadecimalDigits[static_cast<unsigned char>(character) >> 4u] << HexadecimalDigits[static_cast<unsigned char>(character) & 0xFu];
+    } else {
+      stream << character;
+    }
+  }
+  stream << '"';
+}
+
+static void writeJson(std::ostream &stream, const std::vector<ResultRecord> &records) {
+  stream << "{\n  \"results\": [";
+  for (std::size_t i = 0; i < records.size(); i++) {
+    const auto &record = records[i];
+    stream << (i == 0 ? "\n" : ",\n") << "    {\"experiment\": ";
+    writeJsonString(stream, record.experiment);
+    stream << ", \"metric\": ";
+    writeJsonString(stream, record.metric);
+    stream << ", \"value\": " << toRoundTripString(record.value) << ", \"unit\": ";
+    writeJsonString(stream, record.unit);
+    stream << ", \"direction\": ";
+    writeJsonString(stream, getMetricDirectionName(record.direction));
+    stream << "}";
+  }
+  stream << (records.empty() ? "]\n}\n" : "\n  ]\n}\n");
+}
+
+static std::vector<ResultRecord> readJson(std::istream &stream) {
+  boost::property_tree::ptree tree;
+  boost::property_tree::read_json(stream, tree);
+  std::vector<ResultRecord> records;
+  for (const auto &[key, child] : tree.get_child("results")) {
+    ResultRecord record;
+    record.experiment = child.get<std::string>("experiment");
+    record.metric = child.get<std::string>("metric");
+    record.value = parseValue(child.get<std::string>("value"));
+    record.unit = child.get<std::string>("unit");
+    record.direction = parseMetricDirection(child.get<std::string>("direction"));
+    records.push_back(std::move(record));
+  }
+  return records;
+}
+
+/**
+ * Every field is quoted, as metric names often contain commas.
+ * */
+static void writeCsvField(std::ostream &stream, const std::string_view field) {
+  stream << '"';
+  for (const auto character : field) {
+    if (character == '"') {
+      stream << '"';
+    }
+    stream << character;
+  }
+  stream << '"';
+}
+
+static constexpr std::string_view CsvHeader = "experiment,metric,value,unit,direction";
+
+static void writeCsv(std::ostream &stream, const std::vector<ResultRecord> &records) {
+  stream << CsvHeader << "\n";
+  for (const auto &record : records) {
+    writeCsvField(stream, record.experiment);
+    stream << ",";
+    writeCsvField(stream, record.metric);
+    stream << "," << toRoundTripString(record.value) << ",";
+    writeCsvField(stream, record.unit);
+    stream << ",";
+    writeCsvField(stream, getMetricDirectionName(record.direction));
+    stream << "\n";
+  }
+}
+
+/**
+ * Splits the text into rows of fields, where quoted fields may contain commas, doubled quotes and line breaks.
+ * */
+[[nodiscard]] static std::vector<std::vector<std::string>> parseCsvRows(const std::string_view text) {
+  std::vector<std::vector<std::string>> rows;
+  std::vector<std::string> row;
+  std::string field;
+  bool quoted = false;
+  for (std::size_t i = 0; i < text.size(); i++) {
+    const auto character = text[i];
+    if (quoted) {
+      if (character != '"') {
+        field += character;
+      } else if (i + 1 < text.size() && text[i + 1] == '"') {
+        field += '"';
+        i++;
+      } else {
+        quoted = false;
+      }
+    } else if (character == '"') {
+      quoted = true;
+    } else if (character == ',') {
+      row.push_back(std::exchange(field, {}));
+    } else if (character == '\n') {
+      row.push_back(std::exchange(field, {}));
+      rows.push_back(std::exchange(row, {}));
+    } else if (character != '\r') {
+      field += character;
+    }
+  }
+  if (quoted) {
+    throw std::runtime_error("The results end inside a quoted field.");
+  }
+  if (!field.empty() || !row.empty()) {
+    row.push_back(std::move(field));
+    rows.push_back(std::move(row));
+  }
+  return rows;
+}
+
+static std::vector<ResultRecord> readCsv(std::istream &stream) {
+  std::ostringstream text;
+  text << stream.rdbuf();
+  const auto rows = parseCsvRows(text.str());
+  static constexpr std::size_t FieldCount = 5;
+  if (rows.empty() || rows.front() != std::vector<std::string>{"experiment", "metric", "value", "unit", "direction"}) {
+    throw std::runtime_error("The results do not start with the header \"" + std::string(CsvHeader) + "\".");
+  }
+  std::vector<ResultRecord> records;
+  for (std::size_t i = 1; i < rows.size(); i++) {
+    const auto &row = rows[i];
+    if (row.size() != FieldCount) {
+      throw std::runtime_error("Row " + std::to_string(i + 1) + " of the results has " + std::to_string(row.size()) + " fields instead of 5.");
+    }
+    records.push_back({row[0], row[1], parseValue(row[2]), row[3], parseMetricDirection(row[4])});
+  }
+  return records;
+}
+
+void writeResults(std::ostream &stream, const std::vector<ResultRecord> &records, const ResultFormat format) {
+  if (format == ResultFormat::Json) {
+    writeJson(stream, records);
+  } else {
+    writeCsv(stream, records);
+  }
+}
+
+std::vector<ResultRecord> readResults(std::istream &stream, const ResultFormat format) {
+  return format == ResultFormat::Json ? readJson(stream) : readCsv(stream);
+}
+
+void writeResultsFile(const std::filesystem::path &path, const std::vector<ResultRecord> &records) {
+  std::ofstream stream(path);
+  if (!stream) {
+    throw std::runtime_error("Could not open " + path.string() + " for writing.");
+  }
+  writeResults(stream, records, getResultFormat(path));
+}
+
+std::vector<ResultRecord> readResultsFile(const std::filesystem::path &path) {
+  std::ifstream stream(path);
+  if (!stream) {
+    throw std::runtime_error("Could not open " + path.string() + " for reading.");
+  }
+  try {
+    return readResults(stream, getResultFormat(path));
+  } catch (const std::runtime_error &error) {
+    throw std::runtime_error("Could not read the results in " + path.string() + ": " + error.what());
+  }
+}
+
+[[nodiscard]] static std::string toValueString(const double value, const std::string_view unit) {
+  auto string = toRoundTripString(value);
+  if (!unit.empty()) {
+    string += " ";
+    string += unit;
+  }
+  return string;
+}
+
+bool compareWithBaseline(const std::vector<ResultRecord> &baseline, const std::vector<ResultRecord> &records, const double threshold) {
+  static constexpr U32 PercentageDecimalPlaces = 1;
+  std::map<std::pair<std::string_view, std::string_view>, const ResultRecord *> baselineRecords;
+  for (const auto &record : baseline) {
+    baselineRecords[{record.experiment, record.metric}] = &record;
+  }
+  std::size_t regressedCount = 0;
+  std::size_t improvedCount = 0;
+  std::size_t unchangedCount = 0;
+  std::size_t newCount = 0;
+  std::cout << "Comparing with the baseline, flagging regressions of more than " << toFixedPrecisionString(100.0 * threshold, PercentageDecimalPlaces)
+            << "%.\n";
+  for (const auto &record : records) {
+    const auto found = baselineRecords.find({record.experiment, record.metric});
+    if (found == std::end(baselineRecords)) {
+      newCount++;
+      continue;
+    }
+    const auto baselineValue = found->second->value;
+    baselineRecords.erase(found);
+    const auto tolerance = threshold * std::abs(baselineValue);
+    bool regressed = false;
+    bool improved = false;
+    switch (record.direction) {
+    case MetricDirection::LowerIsBetter:
+      regressed = record.value > baselineValue + tolerance;
+      improved = record.value < baselineValue - tolerance;
+      break;
+    case MetricDirection::HigherIsBetter:
+      regressed = record.value < baselineValue - tolerance;
+      improved = record.value > baselineValue + tolerance;
+      break;
+    case MetricDirection::Exact:
+      regressed = record.value != baselineValue;
+      break;
+    }
+    if (improved) {
+      improvedCount++;
+    } else if (!regressed) {
+      unchangedCount++;
+    }
+    if (!regressed) {
+      continue;
+    }
+    regressedCount++;
+    std::cout << Indentation << Warning << record.experiment << ": " << record.metric << " went from " << toValueString(baselineValue, record.unit) << " to "
+              << toValueString(record.value, record.unit);
+    if (baselineValue != 0.0) {
+      std::cout << " (" << (record.value > baselineValue ? "+" : "")
+                << toFixedPrecisionString(100.0 * (record.value - baselineValue) / std::abs(baselineValue), PercentageDecimalPlaces) << "%)";
+    }
+    std::cout << ".\n";
+  }
+  for (const auto &[key, record] : baselineRecords) {
+    std::cout << Indentation << Warning << record->experiment << ": " << record->metric << " is in the baseline but was not measured.\n";
+  }
+  std::cout << Indentation << pluralizeAsNeeded(regressedCount, "metric") << " regressed, " << improvedCount << " improved, " << unchangedCount
+            << " did not change beyond the threshold, " << newCount << " are not in the baseline and " << baselineRecords.size()
+            << " were not measured.\n";
+  return regressedCount != 0 || !baselineRecords.empty();
+}
+} // namespace Experiments
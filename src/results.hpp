@@ -0,0 +1,87 @@
+#pragma once
+
+#include <filesystem>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace Experiments {
+/**
+ * Tells in which direction a change of a metric is a regression.
+ * */
+enum class MetricDirection {
+  LowerIsBetter,
+  HigherIsBetter,
+  /**
+   * Any change is a regression, such as a change of the growth factor of std::vector or of the size of its small string optimization.
+   * */
+  Exact
+};
+
+enum class ResultFormat { Json, Csv };
+
+struct ResultRecord {
+  std::string experiment;
+  std::string metric;
+  double value = 0.0;
+  std::string unit;
+  MetricDirection direction = MetricDirection::LowerIsBetter;
+};
+
+/**
+ * Records a result of the running experiment alongside what it prints, if a ResultRecorder is alive, and does nothing otherwise.
+ *
+ * May be called from any thread. Values which are not finite are not recorded, as JSON cannot represent them.
+ * */
+void recordResult(std::string_view metric, double value, std::string_view unit, MetricDirection direction = MetricDirection::LowerIsBetter);
+
+/**
+ * Collects the results recorded while it is alive, attributing them to the given experiment. Only one recorder may be alive at a time.
+ * */
+class ResultRecorder {
+  std::string experimentName;
+  std::vector<ResultRecord> records;
+
+  friend void recordResult(std::string_view metric, double value, std::string_view unit, MetricDirection direction);
+
+public:
+  explicit ResultRecorder(std::string experiment);
+
+  ResultRecorder(const ResultRecorder &) = delete;
+
+  ResultRecorder &operator=(const ResultRecorder &) = delete;
+
+  /**
+   * Returns the results recorded so far, in the order in which they were recorded, and clears them.
+   * */
+  [[nodiscard]] std::vector<ResultRecord> takeRecords();
+
+  ~ResultRecorder();
+};
+
+/**
+ * Returns the format of a results file from its extension, which is .json or .csv, and throws std::invalid_argument for any other extension.
+ * */
+[[nodiscard]] ResultFormat getResultFormat(const std::filesystem::path &path);
+
+void writeResults(std::ostream &stream, const std::vector<ResultRecord> &records, ResultFormat format);
+
+/**
+ * Throws std::runtime_error if the stream does not hold results in the format.
+ * */
+[[nodiscard]] std::vector<ResultRecord> readResults(std::istream &stream, ResultFormat format);
+
+void writeResultsFile(const std::filesystem::path &path, const std::vector<ResultRecord> &records);
+
+[[nodiscard]] std::vector<ResultRecord> readResultsFile(const std::filesystem::path &path);
+
+/**
+ * Prints how the metrics changed from the baseline, flagging those which regressed by more than the threshold, a fraction of their baseline value, and
+ * returns whether any regressed or was not measured.
+ *
+ * Metrics whose direction is Exact regress on any change. Metrics of the baseline which are missing from the results are flagged, as the experiment which
+ * measures them may have failed, while new metrics are only counted.
+ * */
+bool compareWithBaseline(const std::vector<ResultRecord> &baseline, const std::vector<ResultRecord> &records, double threshold);
+} // namespace Experiments
@@ -1,9 +1,22 @@
 #include "shared_ptr.hpp"
 
 #include <array>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <iomanip>
+#include <iostream>
 #include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
 
+#include "formatting.hpp"
 #include "memory.hpp"
+#include "results.hpp"
+#include "timing.hpp"
 #include "types.hpp"
 
 void Experiments::testSharedPointerMemoryAllocations() {
@@ -25,3 +38,135 @@ void Experiments::testSharedPointerMemoryAllocations() {
     const auto sharedPtr = std::shared_ptr<std::array<U8, 128>>{new std::array<U8, 128>};
   }
 }
+
+namespace Experiments {
+namespace {
+/**
+ * An object which counts its own references, with an atomic count if it is shared between threads.
+ * */
+template <bool Atomic> struct ReferenceCountedValue {
+  std::conditional_t<Atomic, std::atomic<std::size_t>, std::size_t> referenceCount{1};
+  U64 value{};
+};
+
+/**
+ * A pointer to an object which counts its own references, so that, unlike std::shared_ptr, it needs no separate control block.
+ * */
+template <bool Atomic> class IntrusivePointer {
+  ReferenceCountedValue<Atomic> *object;
+
+public:
+  IntrusivePointer() : object(new ReferenceCountedValue<Atomic>) {}
+
+  IntrusivePointer(const IntrusivePointer &rhs) noexcept : object(rhs.object) {
+    if constexpr (Atomic) {
+      // Holding a reference already keeps the object alive, so the increment needs no ordering.
+      object->referenceCount.fetch_add(1, std::memory_order_relaxed);
+    } else {
+      object->referenceCount++;
+    }
+  }
+
+  IntrusivePointer &operator=(const IntrusivePointer &) = delete;
+
+  ~IntrusivePointer() {
+    if constexpr (Atomic) {
+      if (object->referenceCount.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        delete object;
+      }
+    } else if (--object->referenceCount == 0) {
+      delete object;
+    }
+  }
+};
+
+/**
+ * A split reference count, where a thread takes a single reference from the shared count and counts its own copies with a count only it touches.
+ * */
+template <typename T> class SplitReferencePointer {
+  struct LocalReferences {
+    std::shared_ptr<T> sharedReference;
+    std::size_t count;
+  };
+
+  LocalReferences *localReferences;
+
+public:
+  explicit SplitReferencePointer(std::shared_ptr<T> pointer) : localReferences(new LocalReferences{std::move(pointer), 1}) {}
+
+  SplitReferencePointer(const SplitReferencePointer &rhs) noexcept : localReferences(rhs.localReferences) { localReferences->count++; }
+
+  SplitReferencePointer &operator=(const SplitReferencePointer &) = delete;
+
+  ~SplitReferencePointer() {
+    if (--localReferences->count == 0) {
+      delete localReferences;
+    }
+  }
+};
+
+struct ReferenceCountingPolicy {
+  std::string_view name;
+  /**
+   * Copies and destroys a pointer the given number of times on the calling thread, which may run it concurrently with other threads.
+   * */
+  std::function<void(std::size_t copies)> run;
+};
+} // namespace
+
+template <typename Pointer> static void copyAndDestroy(const Pointer &pointer, const std::size_t copies) {
+  for (std::size_t i = 0; i < copies; i++) {
+    Pointer copy(pointer);
+    preventOptimization(copy);
+  }
+}
+
+void testSharedPointerContention() {
+  static constexpr std::size_t CopiesPerThread = 1'000'000;
+  static constexpr std::size_t Repetitions = 3;
+  static constexpr int NameWidth = 46;
+  static constexpr int ColumnWidth = 12;
+  static constexpr U32 ThroughputDecimalPlaces = 1;
+  const auto sharedPointer = std::make_shared<U64>();
+  const IntrusivePointer<true> intrusivePointer;
+  const std::atomic<std::shared_ptr<U64>> atomicSharedPointer(sharedPointer);
+  const std::array<ReferenceCountingPolicy, 5> policies{
+      ReferenceCountingPolicy{"std::shared_ptr", [&sharedPointer](const std::size_t copies) { copyAndDestroy(sharedPointer, copies); }},
+      ReferenceCountingPolicy{"intrusive atomic count", [&intrusivePointer](const std::size_t copies) { copyAndDestroy(intrusivePointer, copies); }},
+      ReferenceCountingPolicy{"non-atomic count, object per thread",
+                              [](const std::size_t copies) { copyAndDestroy(IntrusivePointer<false>(), copies); }},
+      ReferenceCountingPolicy{"std::atomic<std::shared_ptr> load",
+                              [&atomicSharedPointer](const std::size_t copies) {
+                                for (std::size_t i = 0; i < copies; i++) {
+                                  auto copy = atomicSharedPointer.load(std::memory_order_acquire);
+                                  preventOptimization(copy);
+                                }
+                              }},
+      ReferenceCountingPolicy{"split count, one shared reference per thread",
+                              [&sharedPointer](const std::size_t copies) { copyAndDestroy(SplitReferencePointer<U64>(sharedPointer), copies); }},
+  };
+  const auto threadCounts = getScalingThreadCounts();
+  std::cout << "Testing reference counting throughput when threads copy and destroy the same pointer, in millions of copies per second.\n";
+  std::cout << Indentation << "This machine runs " << pluralizeAsNeeded(threadCounts.back(), "hardware thread") << ".\n";
+  std::cout << Indentation << std::setw(NameWidth) << std::left << "Threads" << std::right;
+  for (const auto threadCount : threadCounts) {
+    std::cout << std::setw(ColumnWidth) << threadCount;
+  }
+  std::cout << "\n";
+  for (const auto &policy : policies) {
+    std::cout << Indentation << std::setw(NameWidth) << std::left << policy.name << std::right;
+    for (const auto threadCount : threadCounts) {
+      std::vector<double> durations;
+      for (std::size_t i = 0; i < Repetitions; i++) {
+        durations.push_back(measureConcurrently(threadCount, [&policy](std::size_t) { policy.run(CopiesPerThread); }));
+      }
+      const auto copies = static_cast<double>(threadCount * CopiesPerThread);
+      const auto millionsOfCopiesPerSecond = copies / computeTimingStatistics(std::move(durations)).median / 1e6;
+      std::cout << std::setw(ColumnWidth) << toFixedPrecisionString(millionsOfCopiesPerSecond, ThroughputDecimalPlaces);
+      const auto metric = std::string(policy.name) + ", " + pluralizeAsNeeded(threadCount, "thread");
+      recordResult(metric, millionsOfCopiesPerSecond, "M copies/s", MetricDirection::HigherIsBetter);
+    }
+    std::cout << "\n";
+  }
+}
+} // namespace Experiments
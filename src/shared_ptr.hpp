@@ -2,4 +2,9 @@
 
 namespace Experiments {
 void testSharedPointerMemoryAllocations();
+
+/**
+ * Measures how the throughput of copying and destroying a pointer scales with the number of threads doing so, for several ways of counting references.
+ * */
+void testSharedPointerContention();
 } // namespace Experiments
\ No newline at end of file
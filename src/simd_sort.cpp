@@ -0,0 +1,55 @@
+#include "simd_sort.hpp"
+
+#include <algorithm>
+
+namespace Experiments {
+bool isSimdSortKernelSupported(const SimdSortKernel kernel) {
+  switch (kernel) {
+  case SimdSortKernel::Avx2:
+    return __builtin_cpu_supports("avx2");
+  case SimdSortKernel::Sse41:
+    return __builtin_cpu_supports("sse4.1");
+  case SimdSortKernel::Scalar:
+    return true;
+  }
+  return false;
+}
+
+SimdSortKernel getBestSimdSortKernel() {
+  static const auto bestKernel = []() {
+    for (const auto kernel : {SimdSortKernel::Avx2, SimdSortKernel::Sse41}) {
+      if (isSimdSortKernelSupported(kernel)) {
+        return kernel;
+      }
+    }
+    return SimdSortKernel::Scalar;
+  }();
+  return bestKernel;
+}
+
+std::string_view getSimdSortKernelName(const SimdSortKernel kernel) {
+  switch (kernel) {
+  case SimdSortKernel::Avx2:
+    return "AVX2";
+  case SimdSortKernel::Sse41:
+    return "SSE4.1";
+  case SimdSortKernel::Scalar:
+    return "scalar";
+  }
+  return "unknown";
+}
+
+void simdSort(std::vector<U32> &keys, const SimdSortKernel kernel) {
+  switch (kernel) {
+  case SimdSortKernel::Avx2:
+    sortKeysWithAvx2(keys.data(), keys.size());
+    return;
+  case SimdSortKernel::Sse41:
+    sortKeysWithSse41(keys.data(), keys.size());
+    return;
+  case SimdSortKernel::Scalar:
+    std::sort(std::begin(keys), std::end(keys));
+    return;
+  }
+}
+} // namespace Experiments
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <string_view>
+#include <vector>
+
+#include "types.hpp"
+
+namespace Experiments {
+enum class SimdSortKernel { Avx2, Sse41, Scalar };
+
+/**
+ * Returns the fastest kernel which this processor supports, as reported by CPUID.
+ * */
+[[nodiscard]] SimdSortKernel getBestSimdSortKernel();
+
+[[nodiscard]] bool isSimdSortKernelSupported(SimdSortKernel kernel);
+
+[[nodiscard]] std::string_view getSimdSortKernelName(SimdSortKernel kernel);
+
+/**
+ * Sorts the keys with a quicksort which partitions with vector instructions and sorts small blocks with bitonic sorting networks held in vector registers.
+ *
+ * The scalar kernel is std::sort. Using a kernel which the processor does not support is undefined behavior.
+ * */
+void simdSort(std::vector<U32> &keys, SimdSortKernel kernel = getBestSimdSortKernel());
+
+/**
+ * These are compiled with the flags for their instruction sets, so they must only be called if the processor supports them.
+ * */
+void sortKeysWithAvx2(U32 *keys, std::size_t size);
+
+void sortKeysWithSse41(U32 *keys, std::size_t size);
+} // namespace Experiments
@@ -0,0 +1,42 @@
+#include <immintrin.h>
+
+#include "simd_sort.hpp"
+#include "simd_sort_kernel.hpp"
+
+namespace Experiments {
+namespace {
+struct Avx2Traits {
+  using Vector = __m256i;
+  static constexpr std::size_t Lanes = 8;
+
+  static constexpr U32 encodeLaneIndex(const U32 lane) { return lane; }
+
+  static Vector load(const U32 *const source) { return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(source)); }
+
+  static void store(U32 *const destination, const Vector vector) { _mm256_storeu_si256(reinterpret_cast<__m256i *>(destination), vector); }
+
+  static Vector broadcast(const U32 key) { return _mm256_set1_epi32(static_cast<int>(key)); }
+
+  static Vector minimum(const Vector a, const Vector b) { return _mm256_min_epu32(a, b); }
+
+  static Vector maximum(const Vector a, const Vector b) { return _mm256_max_epu32(a, b); }
+
+  static Vector permute(const Vector vector, const U32 *const permutation) { return _mm256_permutevar8x32_epi32(vector, load(permutation)); }
+
+  static Vector select(const Vector ifClear, const Vector ifSet, const U32 *const mask) { return _mm256_blendv_epi8(ifClear, ifSet, load(mask)); }
+
+  static Vector reverse(const Vector vector) { return _mm256_permutevar8x32_epi32(vector, _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0)); }
+
+  /**
+   * There is no unsigned comparison, so the sign bits are flipped to compare as signed integers.
+   * */
+  static unsigned getGreaterMask(const Vector vector, const Vector pivot) {
+    const auto signBit = _mm256_set1_epi32(static_cast<int>(0x80000000u));
+    const auto greater = _mm256_cmpgt_epi32(_mm256_xor_si256(vector, signBit), _mm256_xor_si256(pivot, signBit));
+    return static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(greater)));
+  }
+};
+} // namespace
+
+void sortKeysWithAvx2(U32 *const keys, const std::size_t size) { SimdSorter<Avx2Traits>::sort(keys, size); }
+} // namespace Experiments
@@ -0,0 +1,310 @@
+#pragma once
+
+#include <cstddef>
+
+#include "types.hpp"
+
+// This header is only included by the translation units which are compiled for a particular instruction set. Everything in it has internal linkage, as the
+// linker could otherwise keep an AVX2 copy of an inline function and call it from the SSE4.1 kernel, so it must not use the standard library either.
+namespace Experiments {
+namespace {
+/**
+ * Vectors whose lanes are sorted or merged together are at most this many, which also bounds the size of the blocks sorted with a sorting network.
+ * */
+static constexpr std::size_t SortingNetworkMaximumVectors = 16;
+
+template <std::size_t Lanes> struct LaneExchangeTable {
+  alignas(64) U32 permutation[Lanes];
+  alignas(64) U32 maximumMask[Lanes];
+};
+
+/**
+ * Makes the table for one step of a bitonic network within a vector.
+ *
+ * If mirrored is set, lane i is compared with the lane at the same distance from the other end of its block of 2 * distance lanes, otherwise with lane
+ * i ^ distance. The lower lane of each pair keeps the minimum, so every step sorts ascending.
+ * */
+template <typename Traits> constexpr LaneExchangeTable<Traits::Lanes> makeLaneExchangeTable(const std::size_t distance, const bool mirrored) {
+  LaneExchangeTable<Traits::Lanes> table{};
+  for (std::size_t lane = 0; lane < Traits::Lanes; lane++) {
+    const auto blockSize = 2 * distance;
+    const auto blockStart = lane / blockSize * blockSize;
+    const auto partner = mirrored ? blockStart + blockSize - 1 - lane % blockSize : lane ^ distance;
+    table.permutation[lane] = Traits::encodeLaneIndex(static_cast<U32>(partner));
+    table.maximumMask[lane] = lane > partner ? ~U32{} : U32{};
+  }
+  return table;
+}
+
+template <std::size_t Lanes> struct CompressTable {
+  alignas(64) U32 permutations[1u << Lanes][Lanes];
+};
+
+/**
+ * For every mask of lanes, makes a permutation which moves the lanes outside the mask to the front and the lanes in the mask to the back.
+ * */
+template <typename Traits> constexpr CompressTable<Traits::Lanes> makeCompressTable() {
+  CompressTable<Traits::Lanes> table{};
+  for (std::size_t mask = 0; mask < (1u << Traits::Lanes); mask++) {
+    std::size_t position = 0;
+    for (std::size_t lane = 0; lane < Traits::Lanes; lane++) {
+      if ((mask & (1u << lane)) == 0) {
+        table.permutations[mask][position++] = Traits::encodeLaneIndex(static_cast<U32>(lane));
+      }
+    }
+    for (std::size_t lane = 0; lane < Traits::Lanes; lane++) {
+      if ((mask & (1u << lane)) != 0) {
+        table.permutations[mask][position++] = Traits::encodeLaneIndex(static_cast<U32>(lane));
+      }
+    }
+  }
+  return table;
+}
+
+template <typename Traits> struct SimdSorter {
+  using Vector = typename Traits::Vector;
+  static constexpr std::size_t Lanes = Traits::Lanes;
+  static constexpr std::size_t SortingNetworkMaximumSize = Lanes * SortingNetworkMaximumVectors;
+
+  static constexpr CompressTable<Lanes> Compress = makeCompressTable<Traits>();
+
+  template <std::size_t Distance, bool Mirrored> static Vector exchangeLanes(const Vector vector) {
+    static constexpr LaneExchangeTable<Lanes> Table = makeLaneExchangeTable<Traits>(Distance, Mirrored);
+    const auto partner = Traits::permute(vector, Table.permutation);
+    return Traits::select(Traits::minimum(vector, partner), Traits::maximum(vector, partner), Table.maximumMask);
+  }
+
+  /**
+   * Sorts a vector which holds a bitonic sequence, such as the output of a bitonic merge between vectors.
+   * */
+  template <std::size_t Distance = Lanes / 2> static Vector mergeLanes(const Vector vector) {
+    if constexpr (Distance == 0) {
+      return vector;
+    } else {
+      return mergeLanes<Distance / 2>(exchangeLanes<Distance, false>(vector));
+    }
+  }
+
+  template <std::size_t Distance = 1> static Vector sortLanes(const Vector vector) {
+    if constexpr (Distance == Lanes) {
+      return vector;
+    } else {
+      auto sorted = exchangeLanes<Distance, true>(vector);
+      if constexpr (Distance > 1) {
+        sorted = mergeLanes<Distance / 2>(sorted);
+      }
+      return sortLanes<Distance * 2>(sorted);
+    }
+  }
+
+  /**
+   * Sorts up to SortingNetworkMaximumSize keys with a bitonic network, padding them with the largest key up to a power of two number of vectors.
+   * */
+  static void sortWithNetwork(U32 *const keys, const std::size_t size) {
+    alignas(64) U32 buffer[SortingNetworkMaximumSize];
+    std::size_t vectorCount = 1;
+    while (vectorCount * Lanes < size) {
+      vectorCount *= 2;
+    }
+    for (std::size_t i = 0; i < vectorCount * Lanes; i++) {
+      buffer[i] = i < size ? keys[i] : ~U32{};
+    }
+    Vector vectors[SortingNetworkMaximumVectors];
+    for (std::size_t i = 0; i < vectorCount; i++) {
+      vectors[i] = sortLanes(Traits::load(buffer + i * Lanes));
+    }
+    for (std::size_t runVectors = 1; runVectors < vectorCount; runVectors *= 2) {
+      for (std::size_t runStart = 0; runStart < vectorCount; runStart += 2 * runVectors) {
+        // Comparing the first run with the reversed second run leaves two bitonic halves, with every key of the first below every key of the second.
+        for (std::size_t i = 0; i < runVectors; i++) {
+          auto &lower = vectors[runStart + i];
+          auto &upper = vectors[runStart + 2 * runVectors - 1 - i];
+          const auto reversedUpper = Traits::reverse(upper);
+          upper = Traits::reverse(Traits::maximum(lower, reversedUpper));
+          lower = Traits::minimum(lower, reversedUpper);
+        }
+        for (auto distance = runVectors / 2; distance > 0; distance /= 2) {
+          for (auto i = runStart; i < runStart + 2 * runVectors; i++) {
+            if ((i & distance) == 0) {
+              const auto lower = vectors[i];
+              vectors[i] = Traits::minimum(lower, vectors[i + distance]);
+              vectors[i + distance] = Traits::maximum(lower, vectors[i + distance]);
+            }
+          }
+        }
+        for (auto i = runStart; i < runStart + 2 * runVectors; i++) {
+          vectors[i] = mergeLanes(vectors[i]);
+        }
+      }
+    }
+    for (std::size_t i = 0; i < vectorCount; i++) {
+      Traits::store(buffer + i * Lanes, vectors[i]);
+    }
+    for (std::size_t i = 0; i < size; i++) {
+      keys[i] = buffer[i];
+    }
+  }
+
+  /**
+   * Moves the keys above the pivot to the back of the vector and returns how many keys are not above it.
+   * */
+  static std::size_t compress(Vector &vector, const Vector pivot) {
+    const auto mask = Traits::getGreaterMask(vector, pivot);
+    vector = Traits::permute(vector, Compress.permutations[mask]);
+    return Lanes - static_cast<std::size_t>(__builtin_popcount(mask));
+  }
+
+  /**
+   * Partitions the keys in place so that the keys not above the pivot come first, and returns how many there are.
+   *
+   * The first and last vectors are held in registers, which leaves room to write a whole vector to both ends after every load. Loading from the end which has
+   * less room left keeps at least a vector of room at each end.
+   * */
+  static std::size_t partition(U32 *const keys, const std::size_t size, const U32 pivotKey) {
+    const auto pivot = Traits::broadcast(pivotKey);
+    if (size < 2 * Lanes) {
+      std::size_t lowerEnd = 0;
+      for (std::size_t i = 0; i < size; i++) {
+        if (keys[i] <= pivotKey) {
+          const auto key = keys[i];
+          keys[i] = keys[lowerEnd];
+          keys[lowerEnd++] = key;
+        }
+      }
+      return lowerEnd;
+    }
+    const auto firstVector = Traits::load(keys);
+    const auto lastVector = Traits::load(keys + size - Lanes);
+    std::size_t readBegin = Lanes;
+    std::size_t readEnd = size - Lanes;
+    std::size_t lowerEnd = 0;
+    std::size_t upperBegin = size;
+    const auto write = [&](Vector vector) {
+      const auto lowerCount = compress(vector, pivot);
+      Traits::store(keys + lowerEnd, vector);
+      Traits::store(keys + upperBegin - Lanes, vector);
+      lowerEnd += lowerCount;
+      upperBegin -= Lanes - lowerCount;
+    };
+    while (readEnd - readBegin >= Lanes) {
+      Vector vector;
+      if (readBegin - lowerEnd <= upperBegin - readEnd) {
+        vector = Traits::load(keys + readBegin);
+        readBegin += Lanes;
+      } else {
+        readEnd -= Lanes;
+        vector = Traits::load(keys + readEnd);
+      }
+      write(vector);
+    }
+    // The remaining keys are copied out first, as all the room may be at one end, where writing would overwrite those not yet read.
+    U32 remainingKeys[Lanes];
+    const auto remainingCount = readEnd - readBegin;
+    for (std::size_t i = 0; i < remainingCount; i++) {
+      remainingKeys[i] = keys[readBegin + i];
+    }
+    for (std::size_t i = 0; i < remainingCount; i++) {
+      const auto key = remainingKeys[i];
+      if (key <= pivotKey) {
+        keys[lowerEnd++] = key;
+      } else {
+        keys[--upperBegin] = key;
+      }
+    }
+    write(firstVector);
+    write(lastVector);
+    return lowerEnd;
+  }
+
+  static void siftDown(U32 *const keys, std::size_t root, const std::size_t size) {
+    while (2 * root + 1 < size) {
+      auto child = 2 * root + 1;
+      if (child + 1 < size && keys[child] < keys[child + 1]) {
+        child++;
+      }
+      if (keys[root] >= keys[child]) {
+        return;
+      }
+      const auto key = keys[root];
+      keys[root] = keys[child];
+      keys[child] = key;
+      root = child;
+    }
+  }
+
+  static void heapSort(U32 *const keys, const std::size_t size) {
+    for (auto i = size / 2; i > 0; i--) {
+      siftDown(keys, i - 1, size);
+    }
+    for (auto end = size; end > 1; end--) {
+      const auto key = keys[0];
+      keys[0] = keys[end - 1];
+      keys[end - 1] = key;
+      siftDown(keys, 0, end - 1);
+    }
+  }
+
+  static U32 getMedian(const U32 a, const U32 b, const U32 c) {
+    if (a < b) {
+      return b < c ? b : (a < c ? c : a);
+    }
+    return a < c ? a : (b < c ? c : b);
+  }
+
+  static U32 choosePivot(const U32 *const keys, const std::size_t size) {
+    // The median of three medians of three resists the inputs which defeat a plain median of three, such as organ pipes.
+    static constexpr std::size_t NintherMinimumSize = 1024;
+    if (size < NintherMinimumSize) {
+      return getMedian(keys[0], keys[size / 2], keys[size - 1]);
+    }
+    const auto step = size / 8;
+    return getMedian(getMedian(keys[0], keys[step], keys[2 * step]), getMedian(keys[3 * step], keys[4 * step], keys[5 * step]),
+                     getMedian(keys[6 * step], keys[7 * step], keys[size - 1]));
+  }
+
+  /**
+   * Recurses into the smaller partition and loops on the larger one, falling back to heap sort once the depth limit shows that the pivots are poor.
+   * */
+  static void quickSort(U32 *keys, std::size_t size, std::size_t depthLimit) {
+    while (size > SortingNetworkMaximumSize) {
+      if (depthLimit == 0) {
+        heapSort(keys, size);
+        return;
+      }
+      depthLimit--;
+      const auto pivot = choosePivot(keys, size);
+      auto lowerSize = partition(keys, size, pivot);
+      if (lowerSize == size) {
+        // Every key is at most the pivot, so the keys equal to it are the largest ones and are split off to avoid recursing forever on repeated keys.
+        if (pivot == 0) {
+          return;
+        }
+        lowerSize = partition(keys, size, pivot - 1);
+        size = lowerSize;
+        continue;
+      }
+      if (lowerSize < size - lowerSize) {
+        quickSort(keys, lowerSize, depthLimit);
+        keys += lowerSize;
+        size -= lowerSize;
+      } else {
+        quickSort(keys + lowerSize, size - lowerSize, depthLimit);
+        size = lowerSize;
+      }
+    }
+    sortWithNetwork(keys, size);
+  }
+
+  static void sort(U32 *const keys, const std::size_t size) {
+    if (size < 2) {
+      return;
+    }
+    std::size_t depthLimit = 0;
+    for (auto remaining = size; remaining > 1; remaining /= 2) {
+      depthLimit += 2;
+    }
+    quickSort(keys, size, depthLimit);
+  }
+};
+} // namespace
+} // namespace Experiments
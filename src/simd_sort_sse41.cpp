@@ -0,0 +1,45 @@
+#include <smmintrin.h>
+
+#include "simd_sort.hpp"
+#include "simd_sort_kernel.hpp"
+
+namespace Experiments {
+namespace {
+struct Sse41Traits {
+  using Vector = __m128i;
+  static constexpr std::size_t Lanes = 4;
+
+  /**
+   * SSE has no variable permutation of 32-bit lanes, so lanes are moved with a byte shuffle which takes the four bytes of the lane.
+   * */
+  static constexpr U32 encodeLaneIndex(const U32 lane) { return 0x03020100u + lane * 0x04040404u; }
+
+  static Vector load(const U32 *const source) { return _mm_loadu_si128(reinterpret_cast<const __m128i *>(source)); }
+
+  static void store(U32 *const destination, const Vector vector) { _mm_storeu_si128(reinterpret_cast<__m128i *>(destination), vector); }
+
+  static Vector broadcast(const U32 key) { return _mm_set1_epi32(static_cast<int>(key)); }
+
+  static Vector minimum(const Vector a, const Vector b) { return _mm_min_epu32(a, b); }
+
+  static Vector maximum(const Vector a, const Vector b) { return _mm_max_epu32(a, b); }
+
+  static Vector permute(const Vector vector, const U32 *const permutation) { return _mm_shuffle_epi8(vector, load(permutation)); }
+
+  static Vector select(const Vector ifClear, const Vector ifSet, const U32 *const mask) { return _mm_blendv_epi8(ifClear, ifSet, load(mask)); }
+
+  static Vector reverse(const Vector vector) { return _mm_shuffle_epi32(vector, _MM_SHUFFLE(0, 1, 2, 3)); }
+
+  /**
+   * There is no unsigned comparison, so the sign bits are flipped to compare as signed integers.
+   * */
+  static unsigned getGreaterMask(const Vector vector, const Vector pivot) {
+    const auto signBit = _mm_set1_epi32(static_cast<int>(0x80000000u));
+    const auto greater = _mm_cmpgt_epi32(_mm_xor_si128(vector, signBit), _mm_xor_si128(pivot, signBit));
+    return static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(greater)));
+  }
+};
+} // namespace
+
+void sortKeysWithSse41(U32 *const keys, const std::size_t size) { SimdSorter<Sse41Traits>::sort(keys, size); }
+} // namespace Experiments
@@ -0,0 +1,276 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+namespace Experiments {
+/**
+ * A string which stores up to N characters inline and only allocates for longer strings, unlike std::string, whose inline capacity the standard library
+ * chooses.
+ * */
+template <std::size_t N> class SmallString {
+  char *characters;
+  std::size_t length = 0;
+  std::size_t characterCapacity = N;
+  char inlineCharacters[N + 1]{};
+
+  [[nodiscard]] bool isInline() const noexcept { return characters == inlineCharacters; }
+
+  void reserveExactly(const std::size_t capacity) {
+    auto *const newCharacters = new char[capacity + 1];
+    std::memcpy(newCharacters, characters, length + 1);
+    release();
+    characters = newCharacters;
+    characterCapacity = capacity;
+  }
+
+  void release() noexcept {
+    if (!isInline()) {
+      delete[] characters;
+    }
+  }
+
+public:
+  using value_type = char;
+
+  static constexpr std::size_t InlineCapacity = N;
+
+  SmallString() noexcept : characters(inlineCharacters) {}
+
+  explicit SmallString(const std::string_view string) : SmallString() { append(string); }
+
+  SmallString(const std::size_t count, const char character) : SmallString() {
+    reserve(count);
+    std::memset(characters, character, count);
+    length = count;
+    characters[length] = '\0';
+  }
+
+  SmallString(const SmallString &rhs) : SmallString(rhs.view()) {}
+
+  SmallString(SmallString &&rhs) noexcept : SmallString() { *this = std::move(rhs); }
+
+  SmallString &operator=(const SmallString &rhs) {
+    if (this != &rhs) {
+      clear();
+      append(rhs.view());
+    }
+    return *this;
+  }
+
+  /**
+   * Takes the heap buffer of the other string if it has one, and copies its characters otherwise.
+   * */
+  SmallString &operator=(SmallString &&rhs) noexcept {
+    if (this == &rhs) {
+      return *this;
+    }
+    release();
+    if (rhs.isInline()) {
+      characters = inlineCharacters;
+      characterCapacity = N;
+      std::memcpy(inlineCharacters, rhs.inlineCharacters, rhs.length + 1);
+    } else {
+      characters = std::exchange(rhs.characters, rhs.inlineCharacters);
+      characterCapacity = std::exchange(rhs.characterCapacity, N);
+    }
+    length = std::exchange(rhs.length, 0);
+    rhs.characters[0] = '\0';
+    return *this;
+  }
+
+  void reserve(const std::size_t capacity) {
+    if (capacity > characterCapacity) {
+      reserveExactly(std::max(capacity, 2 * characterCapacity));
+    }
+  }
+
+  void append(const std::string_view string) {
+    reserve(length + string.size());
+    std::memcpy(characters + length, string.data(), string.size());
+    length += string.size();
+    characters[length] = '\0';
+  }
+
+  void push_back(const char character) { append(std::string_view(&character, 1)); }
+
+  void clear() noexcept {
+    length = 0;
+    characters[0] = '\0';
+  }
+
+  [[nodiscard]] const char *data() const noexcept { return characters; }
+
+  [[nodiscard]] const char *c_str() const noexcept { return characters; }
+
+  [[nodiscard]] std::size_t size() const noexcept { return length; }
+
+  [[nodiscard]] std::size_t capacity() const noexcept { return characterCapacity; }
+
+  [[nodiscard]] std::string_view view() const noexcept { return {characters, length}; }
+
+  explicit(false) operator std::string_view() const noexcept { return view(); }
+
+  [[nodiscard]] friend bool operator==(const SmallString &lhs, const SmallString &rhs) noexcept { return lhs.view() == rhs.view(); }
+
+  ~SmallString() { release(); }
+};
+
+/**
+ * A vector which stores up to N elements inline and only allocates once it grows beyond them.
+ * */
+template <typename T, std::size_t N> class SmallVector {
+  T *elements;
+  std::size_t elementCount = 0;
+  std::size_t elementCapacity = N;
+  alignas(T) std::byte inlineStorage[N * sizeof(T)];
+
+  [[nodiscard]] T *getInlineElements() noexcept { return reinterpret_cast<T *>(inlineStorage); }
+
+  [[nodiscard]] bool isInline() const noexcept { return elements == reinterpret_cast<const T *>(inlineStorage); }
+
+  /**
+   * Moves the elements into a heap buffer of the given capacity and, if ConstructsElement is set, constructs an element from the arguments after them.
+   *
+   * The arguments may refer to an element, so the new element is constructed before the elements are moved out of the old storage.
+   * */
+  template <bool ConstructsElement = false, typename... Arguments> void relocate(const std::size_t capacity, Arguments &&...arguments) {
+    auto *const newElements = std::allocator<T>().allocate(capacity);
+    std::size_t constructedCount = 0;
+    try {
+      if constexpr (ConstructsElement) {
+        std::construct_at(newElements + elementCount, std::forward<Arguments>(arguments)...);
+        constructedCount = 1;
+      }
+      std::uninitialized_move(elements, elements + elementCount, newElements);
+    } catch (...) {
+      std::destroy_n(newElements + elementCount, constructedCount);
+      std::allocator<T>().deallocate(newElements, capacity);
+      throw;
+    }
+    std::destroy(elements, elements + elementCount);
+    release();
+    elements = newElements;
+    elementCapacity = capacity;
+  }
+
+  void release() noexcept {
+    if (!isInline()) {
+      std::allocator<T>().deallocate(elements, elementCapacity);
+    }
+  }
+
+public:
+  using value_type = T;
+
+  static constexpr std::size_t InlineCapacity = N;
+
+  SmallVector() noexcept : elements(getInlineElements()) {}
+
+  SmallVector(const std::size_t count, const T &value) : SmallVector() {
+    reserve(count);
+    std::uninitialized_fill_n(elements, count, value);
+    elementCount = count;
+  }
+
+  SmallVector(const SmallVector &rhs) : SmallVector() {
+    reserve(rhs.elementCount);
+    std::uninitialized_copy(rhs.begin(), rhs.end(), elements);
+    elementCount = rhs.elementCount;
+  }
+
+  SmallVector(SmallVector &&rhs) noexcept(std::is_nothrow_move_constructible_v<T>) : SmallVector() { *this = std::move(rhs); }
+
+  SmallVector &operator=(const SmallVector &rhs) {
+    if (this != &rhs) {
+      clear();
+      reserve(rhs.elementCount);
+      std::uninitialized_copy(rhs.begin(), rhs.end(), elements);
+      elementCount = rhs.elementCount;
+    }
+    return *this;
+  }
+
+  /**
+   * Takes the heap buffer of the other vector if it has one, and moves its elements one by one otherwise.
+   * */
+  SmallVector &operator=(SmallVector &&rhs) noexcept(std::is_nothrow_move_constructible_v<T>) {
+    if (this == &rhs) {
+      return *this;
+    }
+    clear();
+    if (rhs.isInline()) {
+      std::uninitialized_move(rhs.begin(), rhs.end(), elements);
+      elementCount = rhs.elementCount;
+      rhs.clear();
+    } else {
+      release();
+      elements = std::exchange(rhs.elements, rhs.getInlineElements());
+      elementCount = std::exchange(rhs.elementCount, 0);
+      elementCapacity = std::exchange(rhs.elementCapacity, N);
+    }
+    return *this;
+  }
+
+  void reserve(const std::size_t capacity) {
+    if (capacity > elementCapacity) {
+      relocate(std::max(capacity, 2 * elementCapacity));
+    }
+  }
+
+  template <typename... Arguments> T &emplace_back(Arguments &&...arguments) {
+    if (elementCount == elementCapacity) [[unlikely]] {
+      relocate<true>(std::max<std::size_t>(1, 2 * elementCapacity), std::forward<Arguments>(arguments)...);
+      return elements[elementCount++];
+    }
+    return *std::construct_at(elements + elementCount++, std::forward<Arguments>(arguments)...);
+  }
+
+  void push_back(const T &element) { emplace_back(element); }
+
+  void push_back(T &&element) { emplace_back(std::move(element)); }
+
+  void pop_back() noexcept { std::destroy_at(elements + --elementCount); }
+
+  /**
+   * Destroys the elements but keeps the heap buffer, if there is one.
+   * */
+  void clear() noexcept {
+    std::destroy(elements, elements + elementCount);
+    elementCount = 0;
+  }
+
+  [[nodiscard]] T &operator[](const std::size_t index) noexcept { return elements[index]; }
+
+  [[nodiscard]] const T &operator[](const std::size_t index) const noexcept { return elements[index]; }
+
+  [[nodiscard]] T *begin() noexcept { return elements; }
+
+  [[nodiscard]] T *end() noexcept { return elements + elementCount; }
+
+  [[nodiscard]] const T *begin() const noexcept { return elements; }
+
+  [[nodiscard]] const T *end() const noexcept { return elements + elementCount; }
+
+  [[nodiscard]] std::size_t size() const noexcept { return elementCount; }
+
+  [[nodiscard]] bool empty() const noexcept { return elementCount == 0; }
+
+  [[nodiscard]] std::size_t capacity() const noexcept { return elementCapacity; }
+
+  ~SmallVector() {
+    clear();
+    release();
+  }
+};
+} // namespace Experiments
+
+template <std::size_t N> struct std::hash<Experiments::SmallString<N>> {
+  std::size_t operator()(const Experiments::SmallString<N> &string) const noexcept { return std::hash<std::string_view>()(string.view()); }
+};
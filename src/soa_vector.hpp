@@ -0,0 +1,93 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <functional>
+#include <span>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace Experiments {
+/**
+ * A vector of records which stores each field in its own contiguous column, so that a loop over some fields only brings those fields into the cache.
+ *
+ * A record is a tuple of references to its fields, as it is not stored anywhere as a whole.
+ * */
+template <typename... Fields> class SoAVector {
+  static_assert(sizeof...(Fields) > 0, "A record must have at least one field.");
+
+  std::tuple<std::vector<Fields>...> columns;
+
+  template <typename T> static void permute(std::vector<T> &column, const std::vector<std::size_t> &order) {
+    std::vector<T> permuted;
+    permuted.reserve(column.size());
+    for (const auto index : order) {
+      permuted.push_back(std::move(column[index]));
+    }
+    column = std::move(permuted);
+  }
+
+public:
+  template <std::size_t Field> using FieldType = std::tuple_element_t<Field, std::tuple<Fields...>>;
+
+  static constexpr std::size_t FieldCount = sizeof...(Fields);
+
+  /**
+   * The bytes a record occupies, which has no padding between the fields unlike a struct of the same fields.
+   * */
+  static constexpr std::size_t RecordSize = (sizeof(Fields) + ...);
+
+  void reserve(const std::size_t capacity) {
+    std::apply([capacity](auto &...column) { (column.reserve(capacity), ...); }, columns);
+  }
+
+  void push_back(const Fields &...values) {
+    std::apply([&values...](auto &...column) { (column.push_back(values), ...); }, columns);
+  }
+
+  void clear() noexcept {
+    std::apply([](auto &...column) { (column.clear(), ...); }, columns);
+  }
+
+  [[nodiscard]] std::size_t size() const noexcept { return std::get<0>(columns).size(); }
+
+  [[nodiscard]] bool empty() const noexcept { return size() == 0; }
+
+  template <std::size_t Field> [[nodiscard]] std::span<FieldType<Field>> column() noexcept { return std::get<Field>(columns); }
+
+  template <std::size_t Field> [[nodiscard]] std::span<const FieldType<Field>> column() const noexcept { return std::get<Field>(columns); }
+
+  [[nodiscard]] std::tuple<Fields &...> operator[](const std::size_t index) noexcept {
+    return std::apply([index](auto &...column) { return std::tie(column[index]...); }, columns);
+  }
+
+  [[nodiscard]] std::tuple<const Fields &...> operator[](const std::size_t index) const noexcept {
+    return std::apply([index](const auto &...column) { return std::tie(column[index]...); }, columns);
+  }
+
+  /**
+   * Sorts the records by one of their fields.
+   *
+   * The keys are sorted together with the indices of their records, which keeps the comparisons on contiguous memory, and then every column is gathered into
+   * the sorted order once. This allocates a buffer of key and index pairs and a new buffer for each column.
+   * */
+  template <std::size_t KeyField, typename Compare = std::less<>> void sortBy(Compare compare = {}) {
+    std::vector<std::size_t> order;
+    order.reserve(size());
+    {
+      const auto keys = column<KeyField>();
+      std::vector<std::pair<FieldType<KeyField>, std::size_t>> keysAndIndices;
+      keysAndIndices.reserve(size());
+      for (std::size_t i = 0; i < size(); i++) {
+        keysAndIndices.emplace_back(keys[i], i);
+      }
+      std::sort(std::begin(keysAndIndices), std::end(keysAndIndices), [&compare](const auto &lhs, const auto &rhs) { return compare(lhs.first, rhs.first); });
+      for (const auto &keyAndIndex : keysAndIndices) {
+        order.push_back(keyAndIndex.second);
+      }
+    }
+    std::apply([&order](auto &...column) { (permute(column, order), ...); }, columns);
+  }
+};
+} // namespace Experiments
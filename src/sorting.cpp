@@ -1,37 +1,260 @@
+#include "sorting.hpp"
+
 #include <algorithm>
+#include <array>
+#include <iomanip>
 #include <iostream>
 #include <numeric>
 #include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
 #include <vector>
 
+#include "experiment_runner.hpp"
 #include "formatting.hpp"
 #include "memory.hpp"
+#include "results.hpp"
+#include "simd_sort.hpp"
+#include "timing.hpp"
+#include "types.hpp"
 
 namespace Experiments {
-static std::vector<std::mt19937::result_type> makeRandomIntegerVector(const std::size_t size) {
-  std::vector<std::mt19937::result_type> integers;
+template <typename Integer> static std::vector<Integer> makeRandomIntegerVector(const std::size_t size) {
+  std::vector<Integer> integers;
   integers.reserve(size);
   std::mt19937 generator(0);
   for (std::size_t i = 0; i < size; i++) {
-    integers.push_back(generator());
+    integers.push_back(static_cast<Integer>(generator()));
   }
   return integers;
 }
 
-template <typename SortFunction> static void testSortFunctionAllocations(const SortFunction &sortFunction, const std::string &name) {
+template <typename Integer = std::mt19937::result_type, typename SortFunction>
+static void testSortFunctionAllocations(const SortFunction &sortFunction, const std::string &name) {
   for (std::size_t size = 10; size <= 1'000'000u; size *= 10) {
-    auto vector = makeRandomIntegerVector(size);
-    std::cout << "Running " << name << " on " << size << " " << getPrettyTypeName<decltype(vector)::value_type>() << " elements.\n";
-    AllocationTrackerGuard allocationTrackerGuard(true, false);
-    sortFunction(std::begin(vector), std::end(vector));
+    auto vector = makeRandomIntegerVector<Integer>(size);
+    std::cout << "Running " << name << " on " << size << " " << getPrettyTypeName<Integer>() << " elements.\n";
+    const auto regionName = name + " of " + std::to_string(size) + " elements";
+    // The allocations are printed and tracked while sorting a copy, so that neither is part of the measured region.
+    auto copy = vector;
+    AllocationStatistics statistics;
+    {
+      AllocationTrackerGuard allocationTrackerGuard(true, false, false, true);
+      sortFunction(copy);
+      statistics = allocationTrackerGuard.getStatistics();
+    }
+    {
+      MeasuredRegion measuredRegion(regionName, size);
+      sortFunction(vector);
+    }
+    recordResult(regionName + ", allocations", static_cast<double>(statistics.allocations), "allocations");
+    if (statistics.allocations != 0) {
+      printMemoryUsage(statistics);
+    }
   }
 }
 
 void testSortAllocations() {
-  testSortFunctionAllocations([](auto begin, auto end) { std::sort(begin, end); }, "std::sort");
+  testSortFunctionAllocations([](auto &vector) { std::sort(std::begin(vector), std::end(vector)); }, "std::sort");
 }
 
 void testStableSortAllocations() {
-  testSortFunctionAllocations([](auto begin, auto end) { std::stable_sort(begin, end); }, "std::stable_sort");
+  testSortFunctionAllocations([](auto &vector) { std::stable_sort(std::begin(vector), std::end(vector)); }, "std::stable_sort");
+}
+
+void testSimdSortAllocations() {
+  const auto kernelName = std::string(getSimdSortKernelName(getBestSimdSortKernel()));
+  testSortFunctionAllocations<U32>([](std::vector<U32> &vector) { simdSort(vector); }, "SIMD sort (" + kernelName + ")");
+}
+
+void radixSort(std::vector<U32> &keys) {
+  static constexpr U32 DigitBits = 8;
+  static constexpr std::size_t DigitValues = 1u << DigitBits;
+  std::vector<U32> buffer(keys.size());
+  // Counting every digit in a single pass over the keys saves three passes.
+  std::array<std::array<std::size_t, DigitValues>, sizeof(U32)> counts{};
+  for (const auto key : keys) {
+    for (std::size_t digit = 0; digit < sizeof(U32); digit++) {
+      counts[digit][(key >> (digit * DigitBits)) & (DigitValues - 1)]++;
+    }
+  }
+  for (std::size_t digit = 0; digit < sizeof(U32); digit++) {
+    auto &digitCounts = counts[digit];
+    // All keys share this digit, so this pass would not reorder anything.
+    if (std::find(std::begin(digitCounts), std::end(digitCounts), keys.size()) != std::end(digitCounts)) {
+      continue;
+    }
+    std::size_t offset = 0;
+    for (auto &count : digitCounts) {
+      offset += std::exchange(count, offset);
+    }
+    for (const auto key : keys) {
+      buffer[digitCounts[(key >> (digit * DigitBits)) & (DigitValues - 1)]++] = key;
+    }
+    keys.swap(buffer);
+  }
+}
+
+enum class KeyDistribution { Random, Sorted, ReverseSorted, FewUnique, OrganPipe, NearlySorted };
+
+static constexpr std::array<KeyDistribution, 6> KeyDistributions{KeyDistribution::Random,    KeyDistribution::Sorted,    KeyDistribution::ReverseSorted,
+                                                                 KeyDistribution::FewUnique, KeyDistribution::OrganPipe, KeyDistribution::NearlySorted};
+
+[[nodiscard]] static std::string_view getKeyDistributionName(const KeyDistribution distribution) {
+  switch (distribution) {
+  case KeyDistribution::Random:
+    return "random";
+  case KeyDistribution::Sorted:
+    return "sorted";
+  case KeyDistribution::ReverseSorted:
+    return "reverse";
+  case KeyDistribution::FewUnique:
+    return "few unique";
+  case KeyDistribution::OrganPipe:
+    return "organ pipe";
+  case KeyDistribution::NearlySorted:
+    return "nearly sorted";
+  }
+  return "unknown";
+}
+
+static std::vector<U32> makeKeys(const KeyDistribution distribution, const std::size_t size) {
+  static constexpr U32 FewUniqueValues = 16;
+  // One percent of the keys are swapped with a random key to make nearly sorted keys.
+  static constexpr std::size_t NearlySortedSwapDivisor = 100;
+  std::mt19937 generator(0);
+  std::vector<U32> keys;
+  keys.reserve(size);
+  for (std::size_t i = 0; i < size; i++) {
+    keys.push_back(static_cast<U32>(generator()));
+  }
+  switch (distribution) {
+  case KeyDistribution::Random:
+    break;
+  case KeyDistribution::Sorted:
+    std::sort(std::begin(keys), std::end(keys));
+    break;
+  case KeyDistribution::ReverseSorted:
+    std::sort(std::begin(keys), std::end(keys), std::greater<>());
+    break;
+  case KeyDistribution::FewUnique:
+    for (auto &key : keys) {
+      key %= FewUniqueValues;
+    }
+    break;
+  case KeyDistribution::OrganPipe:
+    std::sort(std::begin(keys), std::begin(keys) + static_cast<std::ptrdiff_t>(size / 2));
+    std::sort(std::begin(keys) + static_cast<std::ptrdiff_t>(size / 2), std::end(keys), std::greater<>());
+    break;
+  case KeyDistribution::NearlySorted:
+    std::sort(std::begin(keys), std::end(keys));
+    if (size > 1) {
+      std::uniform_int_distribution<std::size_t> indexDistribution(0, size - 1);
+      for (std::size_t i = 0; i < size / NearlySortedSwapDivisor; i++) {
+        std::swap(keys[indexDistribution(generator)], keys[indexDistribution(generator)]);
+      }
+    }
+    break;
+  }
+  return keys;
+}
+
+namespace {
+struct KeySortFunction {
+  std::string_view name;
+  void (*function)(std::vector<U32> &keys);
+};
+} // namespace
+
+static std::vector<KeySortFunction> makeKeySortFunctions() {
+  std::vector<KeySortFunction> keySortFunctions{
+      {"std::sort", [](std::vector<U32> &keys) { std::sort(std::begin(keys), std::end(keys)); }},
+      {"std::stable_sort", [](std::vector<U32> &keys) { std::stable_sort(std::begin(keys), std::end(keys)); }},
+      {"std::ranges::sort", [](std::vector<U32> &keys) { std::ranges::sort(keys); }},
+      {"heap sort",
+       [](std::vector<U32> &keys) {
+         std::make_heap(std::begin(keys), std::end(keys));
+         std::sort_heap(std::begin(keys), std::end(keys));
+       }},
+      {"LSD radix sort", radixSort},
+  };
+  if (isSimdSortKernelSupported(SimdSortKernel::Sse41)) {
+    keySortFunctions.push_back({"SIMD sort (SSE4.1)", [](std::vector<U32> &keys) { simdSort(keys, SimdSortKernel::Sse41); }});
+  }
+  if (isSimdSortKernelSupported(SimdSortKernel::Avx2)) {
+    keySortFunctions.push_back({"SIMD sort (AVX2)", [](std::vector<U32> &keys) { simdSort(keys, SimdSortKernel::Avx2); }});
+  }
+  return keySortFunctions;
+}
+
+static const std::vector<KeySortFunction> &getKeySortFunctions() {
+  static const auto keySortFunctions = makeKeySortFunctions();
+  return keySortFunctions;
+}
+
+void testSortingThroughput() {
+  static constexpr std::size_t MaximumSize = 100'000'000;
+  // Small inputs are sorted in batches of copies, timed together, so that every sample sorts at least this many keys and lasts far longer than a tick
+  // of the clock.
+  static constexpr std::size_t KeysPerSample = 100'000;
+  // Each input size takes enough samples to sort about this many keys, within the bounds below.
+  static constexpr std::size_t KeysPerMeasurement = 1'000'000;
+  static constexpr std::size_t MinimumSamples = 3;
+  static constexpr std::size_t MaximumSamples = 10;
+  static constexpr int NameWidth = 20;
+  static constexpr int ColumnWidth = 14;
+  static constexpr U32 ThroughputDecimalPlaces = 2;
+  const auto maximumSize = std::min(MaximumSize, getExperimentOptions().maximumElementCount);
+  std::cout << "Testing the throughput of sorting 32-bit keys, in millions of keys per second at the median.\n";
+  for (std::size_t size = 10; size <= maximumSize; size *= 10) {
+    const auto batchSize = std::max(std::size_t{1}, KeysPerSample / size);
+    const auto samples = std::clamp(KeysPerMeasurement / (batchSize * size), MinimumSamples, MaximumSamples);
+    std::cout << Indentation << toStringWithThousandsSeparators(size) << " keys, " << pluralizeAsNeeded(samples, "sample") << " of ";
+    std::cout << pluralizeAsNeeded(batchSize, "sort") << ":\n";
+    std::cout << Indentation << std::setw(NameWidth) << "";
+    for (const auto distribution : KeyDistributions) {
+      std::cout << std::setw(ColumnWidth) << getKeyDistributionName(distribution);
+    }
+    std::cout << "\n";
+    const auto &keySortFunctions = getKeySortFunctions();
+    // Only the keys of one distribution are held at a time, so that the largest inputs fit in memory, and the table is printed once all are sorted.
+    std::vector<std::vector<double>> throughputs(keySortFunctions.size());
+    for (const auto distribution : KeyDistributions) {
+      const auto input = makeKeys(distribution, size);
+      auto expectedOutput = input;
+      std::sort(std::begin(expectedOutput), std::end(expectedOutput));
+      for (std::size_t i = 0; i < keySortFunctions.size(); i++) {
+        const auto &keySortFunction = keySortFunctions[i];
+        std::vector<std::vector<U32>> batch(batchSize);
+        const auto statistics = measureRepeatedly(
+            samples,
+            [&batch, &input]() {
+              for (auto &keys : batch) {
+                keys = input;
+              }
+            },
+            [&batch, &keySortFunction]() {
+              for (auto &keys : batch) {
+                keySortFunction.function(keys);
+              }
+            });
+        if (std::any_of(std::begin(batch), std::end(batch), [&expectedOutput](const std::vector<U32> &keys) { return keys != expectedOutput; })) {
+          throw std::logic_error(std::string(keySortFunction.name) + " did not produce the output of std::sort.");
+        }
+        const auto millionsOfKeysPerSecond = static_cast<double>(size * batchSize) / statistics.median / 1e6;
+        throughputs[i].push_back(millionsOfKeysPerSecond);
+        const auto metric = std::string(keySortFunction.name) + " of " + std::to_string(size) + " " + std::string(getKeyDistributionName(distribution));
+        recordResult(metric + " keys", millionsOfKeysPerSecond, "M keys/s", MetricDirection::HigherIsBetter);
+      }
+    }
+    for (std::size_t i = 0; i < keySortFunctions.size(); i++) {
+      std::cout << Indentation << std::setw(NameWidth) << std::left << keySortFunctions[i].name << std::right;
+      for (const auto millionsOfKeysPerSecond : throughputs[i]) {
+        std::cout << std::setw(ColumnWidth) << toFixedPrecisionString(millionsOfKeysPerSecond, ThroughputDecimalPlaces);
+      }
+      std::cout << "\n";
+    }
+  }
 }
 } // namespace Experiments
\ No newline at end of file
@@ -1,6 +1,23 @@
+#pragma once
+
+#include <vector>
+
+#include "types.hpp"
+
 namespace Experiments {
+/**
+ * Sorts the keys with a least significant digit radix sort, one byte at a time.
+ * */
+void radixSort(std::vector<U32> &keys);
 
 void testSortAllocations();
 
 void testStableSortAllocations();
-} // namespace Experiments
\ No newline at end of file
+
+void testSimdSortAllocations();
+
+/**
+ * Compares the throughput of several sorting algorithms on 32-bit keys of different sizes and distributions.
+ * */
+void testSortingThroughput();
+} // namespace Experiments
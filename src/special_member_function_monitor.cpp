@@ -1,31 +1,39 @@
 #include "special_member_function_monitor.hpp"
 
-namespace Experiments {
-U64 SpecialMemberFunctionMonitor::constructor = 0;
-U64 SpecialMemberFunctionMonitor::copyConstructor = 0;
-U64 SpecialMemberFunctionMonitor::moveConstructor = 0;
-U64 SpecialMemberFunctionMonitor::copyAssignment = 0;
-U64 SpecialMemberFunctionMonitor::moveAssignment = 0;
-U64 SpecialMemberFunctionMonitor::destructor = 0;
-
-SpecialMemberFunctionMonitor::SpecialMemberFunctionMonitor() { constructor++; }
-
-SpecialMemberFunctionMonitor::SpecialMemberFunctionMonitor(const SpecialMemberFunctionMonitor &) noexcept { copyConstructor++; }
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
-SpecialMemberFunctionMonitor::SpecialMemberFunctionMonitor(SpecialMemberFunctionMonitor &&) noexcept { moveConstructor++; }
+#include "formatting.hpp"
+#include "results.hpp"
 
-SpecialMemberFunctionMonitor &SpecialMemberFunctionMonitor::operator=(const SpecialMemberFunctionMonitor &) noexcept {
-  copyAssignment++;
-  return *this;
+namespace Experiments {
+SpecialMemberFunctionCallCounts AtomicSpecialMemberFunctionCallCounts::load() const noexcept {
+  SpecialMemberFunctionCallCounts callCounts;
+  callCounts.constructor = constructor.load(std::memory_order_relaxed);
+  callCounts.copyConstructor = copyConstructor.load(std::memory_order_relaxed);
+  callCounts.moveConstructor = moveConstructor.load(std::memory_order_relaxed);
+  callCounts.copyAssignment = copyAssignment.load(std::memory_order_relaxed);
+  callCounts.moveAssignment = moveAssignment.load(std::memory_order_relaxed);
+  callCounts.destructor = destructor.load(std::memory_order_relaxed);
+  return callCounts;
 }
 
-SpecialMemberFunctionMonitor &SpecialMemberFunctionMonitor::operator=(SpecialMemberFunctionMonitor &&) noexcept {
-  moveAssignment++;
-  return *this;
+void AtomicSpecialMemberFunctionCallCounts::reset() noexcept {
+  constructor.store(0, std::memory_order_relaxed);
+  copyConstructor.store(0, std::memory_order_relaxed);
+  moveConstructor.store(0, std::memory_order_relaxed);
+  copyAssignment.store(0, std::memory_order_relaxed);
+  moveAssignment.store(0, std::memory_order_relaxed);
+  destructor.store(0, std::memory_order_relaxed);
 }
 
-SpecialMemberFunctionMonitor::~SpecialMemberFunctionMonitor() { destructor++; }
-
 static void addCallCountString(std::vector<std::string> &callCountStrings, const U64 callCount, const std::string &what) {
   if (callCount == 0) {
     return;
@@ -40,14 +48,14 @@ static void addCallCountString(std::vector<std::string> &callCountStrings, const
   callCountStrings.push_back(std::move(string));
 }
 
-void SpecialMemberFunctionMonitor::print() {
+void printSpecialMemberFunctionCallCounts(const SpecialMemberFunctionCallCounts &callCounts) {
   std::vector<std::string> callCountStrings;
-  addCallCountString(callCountStrings, constructor, "constructor");
-  addCallCountString(callCountStrings, copyConstructor, "copy constructor");
-  addCallCountString(callCountStrings, moveConstructor, "move constructor");
-  addCallCountString(callCountStrings, copyAssignment, "copy assignment operator");
-  addCallCountString(callCountStrings, moveAssignment, "move assignment operator");
-  addCallCountString(callCountStrings, destructor, "destructor");
+  addCallCountString(callCountStrings, callCounts.constructor, "constructor");
+  addCallCountString(callCountStrings, callCounts.copyConstructor, "copy constructor");
+  addCallCountString(callCountStrings, callCounts.moveConstructor, "move constructor");
+  addCallCountString(callCountStrings, callCounts.copyAssignment, "copy assignment operator");
+  addCallCountString(callCountStrings, callCounts.moveAssignment, "move assignment operator");
+  addCallCountString(callCountStrings, callCounts.destructor, "destructor");
   std::cout << "made ";
   if (callCountStrings.empty()) {
     std::cout << "no calls";
@@ -57,12 +65,106 @@ void SpecialMemberFunctionMonitor::print() {
   std::cout << ".";
 }
 
-void SpecialMemberFunctionMonitor::reset() {
-  constructor = 0;
-  copyConstructor = 0;
-  moveConstructor = 0;
-  copyAssignment = 0;
-  moveAssignment = 0;
-  destructor = 0;
+namespace {
+struct VectorReallocationTag;
+struct SortTag;
+struct UnorderedMapTag;
+
+template <typename Tag, bool MoveIsNoexcept> struct KeyedMonitor : SpecialMemberFunctionMonitor<Tag, MoveIsNoexcept> {
+  U32 key = 0;
+};
+
+struct CopiesAndMoves {
+  U64 copies;
+  U64 moves;
+};
+} // namespace
+
+static constexpr U32 HiddenCopiesElementCount = 1000;
+
+/**
+ * Resets the counters of the monitor, runs the function and returns the copies and moves it made.
+ * */
+template <typename Monitor, typename Function> static CopiesAndMoves countCopiesAndMoves(Function function) {
+  Monitor::reset();
+  function();
+  const auto callCounts = Monitor::getCallCounts();
+  return {callCounts.getCopies(), callCounts.getMoves()};
+}
+
+template <bool MoveIsNoexcept> static CopiesAndMoves countVectorReallocationCopiesAndMoves() {
+  using Monitor = SpecialMemberFunctionMonitor<VectorReallocationTag, MoveIsNoexcept>;
+  return countCopiesAndMoves<Monitor>([]() {
+    std::vector<Monitor> vector;
+    for (U32 i = 0; i < HiddenCopiesElementCount; i++) {
+      vector.emplace_back();
+    }
+  });
+}
+
+template <bool MoveIsNoexcept> static CopiesAndMoves countSortCopiesAndMoves() {
+  using Element = KeyedMonitor<SortTag, MoveIsNoexcept>;
+  std::vector<Element> elements(HiddenCopiesElementCount);
+  for (U32 i = 0; i < HiddenCopiesElementCount; i++) {
+    // A permutation of the keys which is neither sorted nor reversed.
+    elements[i].key = i * 7919u % HiddenCopiesElementCount;
+  }
+  return countCopiesAndMoves<SpecialMemberFunctionMonitor<SortTag, MoveIsNoexcept>>(
+      [&elements]() { std::sort(std::begin(elements), std::end(elements), [](const Element &lhs, const Element &rhs) { return lhs.key < rhs.key; }); });
+}
+
+template <bool MoveIsNoexcept> static CopiesAndMoves countUnorderedMapRehashCopiesAndMoves() {
+  using Monitor = SpecialMemberFunctionMonitor<UnorderedMapTag, MoveIsNoexcept>;
+  std::unordered_map<U32, Monitor> map;
+  for (U32 i = 0; i < HiddenCopiesElementCount; i++) {
+    map.try_emplace(i);
+  }
+  return countCopiesAndMoves<Monitor>([&map]() { map.rehash(16 * map.bucket_count()); });
+}
+
+template <bool MoveIsNoexcept> static CopiesAndMoves countUnorderedMapInsertionCopiesAndMoves() {
+  using Monitor = SpecialMemberFunctionMonitor<UnorderedMapTag, MoveIsNoexcept>;
+  return countCopiesAndMoves<Monitor>([]() {
+    std::unordered_map<U32, Monitor> map;
+    for (U32 i = 0; i < HiddenCopiesElementCount; i++) {
+      map.insert({i, Monitor()});
+    }
+  });
+}
+
+void testHiddenCopies() {
+  static_assert(std::is_nothrow_move_constructible_v<SpecialMemberFunctionMonitor<VectorReallocationTag, true>>);
+  static_assert(!std::is_nothrow_move_constructible_v<SpecialMemberFunctionMonitor<VectorReallocationTag, false>>);
+  static constexpr int SituationWidth = 48;
+  static constexpr int ColumnWidth = 16;
+  std::cout << "Testing the copies and moves of " << toStringWithThousandsSeparators(HiddenCopiesElementCount)
+            << " elements whose move constructor is noexcept or may throw.\n";
+  std::cout << Indentation << std::setw(SituationWidth) << "" << std::setw(2 * ColumnWidth) << "noexcept move" << std::setw(2 * ColumnWidth)
+            << "throwing move" << "\n";
+  std::cout << Indentation << std::setw(SituationWidth) << "";
+  for (std::size_t i = 0; i < 2; i++) {
+    std::cout << std::setw(ColumnWidth) << "Copies" << std::setw(ColumnWidth) << "Moves";
+  }
+  std::cout << "\n";
+  const auto printSituation = [](const std::string_view situation, const CopiesAndMoves noexceptMove, const CopiesAndMoves throwingMove) {
+    std::cout << Indentation << std::setw(SituationWidth) << std::left << situation << std::right;
+    for (const auto copiesAndMoves : {noexceptMove, throwingMove}) {
+      std::cout << std::setw(ColumnWidth) << toStringWithThousandsSeparators(copiesAndMoves.copies) << std::setw(ColumnWidth)
+                << toStringWithThousandsSeparators(copiesAndMoves.moves);
+    }
+    std::cout << "\n";
+    for (const auto &[moveName, copiesAndMoves] : {std::pair{"noexcept move", noexceptMove}, std::pair{"throwing move", throwingMove}}) {
+      const auto metric = std::string(situation) + ", " + moveName;
+      recordResult(metric + ", copies", static_cast<double>(copiesAndMoves.copies), "copies", MetricDirection::Exact);
+      recordResult(metric + ", moves", static_cast<double>(copiesAndMoves.moves), "moves", MetricDirection::Exact);
+    }
+  };
+  printSituation("std::vector reallocation by emplace_back", countVectorReallocationCopiesAndMoves<true>(),
+                 countVectorReallocationCopiesAndMoves<false>());
+  printSituation("std::sort", countSortCopiesAndMoves<true>(), countSortCopiesAndMoves<false>());
+  printSituation("std::unordered_map insertion of rvalue pairs", countUnorderedMapInsertionCopiesAndMoves<true>(),
+                 countUnorderedMapInsertionCopiesAndMoves<false>());
+  printSituation("std::unordered_map rehash", countUnorderedMapRehashCopiesAndMoves<true>(), countUnorderedMapRehashCopiesAndMoves<false>());
+  std::cout << Indentation << "std::vector copies instead of moving when moving may throw, as it could not undo a move which threw halfway through.\n";
 }
 } // namespace Experiments
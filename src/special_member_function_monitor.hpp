@@ -1,29 +1,94 @@
 #pragma once
 
-#include <iostream>
+#include <atomic>
 
-#include "formatting.hpp"
 #include "types.hpp"
 
 namespace Experiments {
-class SpecialMemberFunctionMonitor {
-  static U64 constructor;
-  static U64 copyConstructor;
-  static U64 moveConstructor;
-  static U64 copyAssignment;
-  static U64 moveAssignment;
-  static U64 destructor;
+struct SpecialMemberFunctionCallCounts {
+  U64 constructor = 0;
+  U64 copyConstructor = 0;
+  U64 moveConstructor = 0;
+  U64 copyAssignment = 0;
+  U64 moveAssignment = 0;
+  U64 destructor = 0;
+
+  [[nodiscard]] U64 getCopies() const noexcept { return copyConstructor + copyAssignment; }
+
+  [[nodiscard]] U64 getMoves() const noexcept { return moveConstructor + moveAssignment; }
+};
+
+/**
+ * Prints the calls as a sentence starting with "made", such as "made 1 call to the constructor and 1 call to the destructor."
+ * */
+void printSpecialMemberFunctionCallCounts(const SpecialMemberFunctionCallCounts &callCounts);
+
+class AtomicSpecialMemberFunctionCallCounts {
+  std::atomic<U64> constructor = 0;
+  std::atomic<U64> copyConstructor = 0;
+  std::atomic<U64> moveConstructor = 0;
+  std::atomic<U64> copyAssignment = 0;
+  std::atomic<U64> moveAssignment = 0;
+  std::atomic<U64> destructor = 0;
+
+  static void increment(std::atomic<U64> &callCount) noexcept { callCount.fetch_add(1, std::memory_order_relaxed); }
+
+public:
+  void countConstructor() noexcept { increment(constructor); }
+
+  void countCopyConstructor() noexcept { increment(copyConstructor); }
+
+  void countMoveConstructor() noexcept { increment(moveConstructor); }
+
+  void countCopyAssignment() noexcept { increment(copyAssignment); }
+
+  void countMoveAssignment() noexcept { increment(moveAssignment); }
+
+  void countDestructor() noexcept { increment(destructor); }
+
+  [[nodiscard]] SpecialMemberFunctionCallCounts load() const noexcept;
+
+  void reset() noexcept;
+};
+
+/**
+ * Counts the calls to its special member functions, which may be made from any thread.
+ *
+ * Each combination of a tag and of whether moving is noexcept has its own counters, so that several monitored types can be used at once. Whether moving is
+ * noexcept decides whether containers such as std::vector move or copy the elements when they relocate them.
+ * */
+template <typename Tag = void, bool MoveIsNoexcept = true> class SpecialMemberFunctionMonitor {
+  static inline AtomicSpecialMemberFunctionCallCounts callCounts;
 
 public:
-  SpecialMemberFunctionMonitor();
-  SpecialMemberFunctionMonitor(const SpecialMemberFunctionMonitor &rhs) noexcept;
-  SpecialMemberFunctionMonitor(SpecialMemberFunctionMonitor &&rhs) noexcept;
-  SpecialMemberFunctionMonitor &operator=(const SpecialMemberFunctionMonitor &rhs) noexcept;
-  SpecialMemberFunctionMonitor &operator=(SpecialMemberFunctionMonitor &&rhs) noexcept;
-  virtual ~SpecialMemberFunctionMonitor();
+  SpecialMemberFunctionMonitor() noexcept { callCounts.countConstructor(); }
+
+  SpecialMemberFunctionMonitor(const SpecialMemberFunctionMonitor &) noexcept { callCounts.countCopyConstructor(); }
 
-  static void print();
+  SpecialMemberFunctionMonitor(SpecialMemberFunctionMonitor &&) noexcept(MoveIsNoexcept) { callCounts.countMoveConstructor(); }
 
-  static void reset();
+  SpecialMemberFunctionMonitor &operator=(const SpecialMemberFunctionMonitor &) noexcept {
+    callCounts.countCopyAssignment();
+    return *this;
+  }
+
+  SpecialMemberFunctionMonitor &operator=(SpecialMemberFunctionMonitor &&) noexcept(MoveIsNoexcept) {
+    callCounts.countMoveAssignment();
+    return *this;
+  }
+
+  virtual ~SpecialMemberFunctionMonitor() { callCounts.countDestructor(); }
+
+  [[nodiscard]] static SpecialMemberFunctionCallCounts getCallCounts() noexcept { return callCounts.load(); }
+
+  static void print() { printSpecialMemberFunctionCallCounts(getCallCounts()); }
+
+  static void reset() noexcept { callCounts.reset(); }
 };
+
+/**
+ * Counts the copies and moves which std::vector makes when it reallocates, std::sort makes and std::unordered_map makes when it rehashes, for elements whose
+ * move constructor is noexcept and for elements whose move constructor may throw.
+ * */
+void testHiddenCopies();
 } // namespace Experiments
@@ -1,25 +1,39 @@
 #include "sso.hpp"
 
+#include "experiment_runner.hpp"
 #include "formatting.hpp"
 #include "memory.hpp"
+#include "results.hpp"
+#include "small_containers.hpp"
+#include "timing.hpp"
 
+#include <algorithm>
+#include <iomanip>
+#include <random>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
 
 namespace Experiments {
-[[nodiscard]] static bool subjectToSmallStringOptimization(std::size_t size) {
+/**
+ * Works for any container which can be constructed from a size and a value, such as strings and vectors.
+ * */
+template <typename Container = std::string> [[nodiscard]] static bool subjectToSmallStringOptimization(std::size_t size) {
   AllocationTrackerGuard allocationTrackerGuard(false, false);
-  std::string string(size, 'A');
+  Container container(size, typename Container::value_type{});
   return allocationTrackerGuard.getAllocationsMade() == 0;
 }
 
-[[nodiscard]] static std::size_t findMaximumSmallStringOptimizationSize() {
+template <typename Container = std::string> [[nodiscard]] static std::size_t findMaximumSmallStringOptimizationSize(const std::size_t maximumSize = 1u << 24u) {
   std::size_t a = 1u;
-  const std::size_t b = (1u << 24u) + 1u;
+  const std::size_t b = maximumSize + 1u;
   auto count = b - a;
   while (count > 0u) {
     const auto step = count / 2u;
     const auto m = a + step;
-    if (subjectToSmallStringOptimization(m)) {
+    if (subjectToSmallStringOptimization<Container>(m)) {
       a = m + 1;
       count -= step + 1u;
     } else {
@@ -29,12 +43,23 @@ namespace Experiments {
   return a - 1u;
 }
 
-void testStringSize() { std::cout << "std::string takes " << pluralizeAsNeeded(sizeof(std::string), "byte") << ".\n"; }
+void testStringSize() {
+  std::cout << "std::string takes " << pluralizeAsNeeded(sizeof(std::string), "byte") << ".\n";
+  recordResult("sizeof(std::string)", sizeof(std::string), "bytes", MetricDirection::Exact);
+}
 
-void testStringMaximumSize() { std::cout << "std::string maximum size: " << toStringWithThousandsSeparators(std::string().max_size()) << "\n"; }
+void testStringMaximumSize() {
+  std::cout << "std::string maximum size: " << toStringWithThousandsSeparators(std::string().max_size()) << "\n";
+  recordResult("std::string maximum size", static_cast<double>(std::string().max_size()), "characters", MetricDirection::Exact);
+}
 
 void testSmallStringOptimizationSize() {
-  const auto maximumSmallStringOptimizationSize = findMaximumSmallStringOptimizationSize();
+  std::size_t maximumSmallStringOptimizationSize = 0;
+  {
+    MeasuredRegion measuredRegion("Binary search for the maximum SSO size");
+    maximumSmallStringOptimizationSize = findMaximumSmallStringOptimizationSize();
+  }
+  recordResult("Maximum SSO size", static_cast<double>(maximumSmallStringOptimizationSize), "bytes", MetricDirection::Exact);
   if (maximumSmallStringOptimizationSize == 0) {
     std::cout << "No small string optimization (SSO) support.\n";
   }
@@ -45,4 +70,160 @@ void testSmallStringOptimizationSize() {
   }
   std::cout << ".\n";
 }
+
+/**
+ * The inline capacity of SmallString which fits the 16 to 40-byte hashed keys the throughput test uses.
+ * */
+static constexpr std::size_t KeyInlineCapacity = 40;
+static constexpr std::size_t VectorInlineCapacity = 16;
+/**
+ * Vectors are only searched up to this size, as the search allocates vectors of up to this many elements.
+ * */
+static constexpr std::size_t MaximumSearchedVectorSize = 1u << 16u;
+
+template <typename Container> static void printInlineStorageRange(const std::size_t maximumInlineSize) {
+  const auto name = getPrettyTypeName<Container>();
+  std::cout << Indentation << name << " ";
+  if (maximumInlineSize == 0) {
+    std::cout << "allocates for every size.\n";
+  } else {
+    std::cout << "does not allocate for sizes of up to " << maximumInlineSize << ".\n";
+  }
+  recordResult(name + " maximum inline size", static_cast<double>(maximumInlineSize), "elements", MetricDirection::Exact);
+}
+
+void testSmallContainerInlineStorage() {
+  using Key = SmallString<KeyInlineCapacity>;
+  using Vector = SmallVector<int, VectorInlineCapacity>;
+  std::cout << "Testing up to which size containers store their elements inline.\n";
+  printInlineStorageRange<std::string>(findMaximumSmallStringOptimizationSize<std::string>());
+  printInlineStorageRange<Key>(findMaximumSmallStringOptimizationSize<Key>());
+  printInlineStorageRange<std::vector<int>>(findMaximumSmallStringOptimizationSize<std::vector<int>>(MaximumSearchedVectorSize));
+  printInlineStorageRange<Vector>(findMaximumSmallStringOptimizationSize<Vector>(MaximumSearchedVectorSize));
+}
+
+[[nodiscard]] static std::vector<std::string> makeRandomKeys(const std::size_t count) {
+  static constexpr std::size_t MinimumKeyLength = 16;
+  static constexpr std::size_t MaximumKeyLength = KeyInlineCapacity;
+  std::mt19937 generator(0);
+  std::uniform_int_distribution<std::size_t> lengthDistribution(MinimumKeyLength, MaximumKeyLength);
+  std::uniform_int_distribution<int> characterDistribution('a', 'z');
+  std::vector<std::string> keys(count);
+  for (auto &key : keys) {
+    key.resize(lengthDistribution(generator));
+    for (auto &character : key) {
+      character = static_cast<char>(characterDistribution(generator));
+    }
+  }
+  return keys;
+}
+
+static void printThroughputAndAllocations(const std::string &name, const double millionsPerSecond, const double allocationsPerOperation) {
+  static constexpr int NameWidth = 46;
+  static constexpr int ColumnWidth = 14;
+  static constexpr U32 ThroughputDecimalPlaces = 2;
+  static constexpr U32 AllocationsDecimalPlaces = 3;
+  std::cout << Indentation << Indentation << std::setw(NameWidth) << std::left << name << std::right << std::setw(ColumnWidth)
+            << toFixedPrecisionString(millionsPerSecond, ThroughputDecimalPlaces) << std::setw(ColumnWidth)
+            << toFixedPrecisionString(allocationsPerOperation, AllocationsDecimalPlaces) << "\n";
+  recordResult(name, millionsPerSecond, "M operations/s", MetricDirection::HigherIsBetter);
+  recordResult(name + ", allocations", allocationsPerOperation, "allocations/operation");
+}
+
+/**
+ * Keys are built from views of the key strings on insertion and on lookup, as they would be from incoming data.
+ * */
+template <typename Key> static void testMapKeyThroughput(const std::string &name, const std::vector<std::string> &keyStrings) {
+  static constexpr std::size_t Repetitions = 3;
+  const auto keyCount = static_cast<double>(keyStrings.size());
+  std::unordered_map<Key, U32> map;
+  const auto insertion = measureRepeatedly(
+      Repetitions, [&map]() { map = std::unordered_map<Key, U32>(); },
+      [&map, &keyStrings]() {
+        for (U32 i = 0; i < keyStrings.size(); i++) {
+          map.emplace(Key(std::string_view(keyStrings[i])), i);
+        }
+      });
+  std::size_t found = 0;
+  const auto lookup = measureRepeatedly(
+      Repetitions, [&found]() { found = 0; },
+      [&map, &keyStrings, &found]() {
+        for (const auto &keyString : keyStrings) {
+          found += map.count(Key(std::string_view(keyString)));
+        }
+      });
+  if (found != keyStrings.size()) {
+    throw std::logic_error(name + " keys were not found in the map.");
+  }
+  std::size_t insertionAllocations = 0;
+  std::size_t lookupAllocations = 0;
+  {
+    AllocationTrackerGuard allocationTrackerGuard(false, false);
+    std::unordered_map<Key, U32> trackedMap;
+    for (U32 i = 0; i < keyStrings.size(); i++) {
+      trackedMap.emplace(Key(std::string_view(keyStrings[i])), i);
+    }
+    insertionAllocations = allocationTrackerGuard.getAllocationsMade();
+    for (const auto &keyString : keyStrings) {
+      found += trackedMap.count(Key(std::string_view(keyString)));
+    }
+    lookupAllocations = allocationTrackerGuard.getAllocationsMade() - insertionAllocations;
+  }
+  printThroughputAndAllocations(name + " insertion", keyCount / insertion.median / 1e6, static_cast<double>(insertionAllocations) / keyCount);
+  printThroughputAndAllocations(name + " lookup", keyCount / lookup.median / 1e6, static_cast<double>(lookupAllocations) / keyCount);
+}
+
+/**
+ * Each temporary vector holds between 1 and 16 elements, which are summed so that the vector is not optimized away.
+ * */
+template <typename Vector> static void testTemporaryVectorThroughput(const std::string &name, const std::size_t vectorCount) {
+  static constexpr std::size_t Repetitions = 3;
+  U64 sum = 0;
+  const auto buildVectors = [&sum, vectorCount]() {
+    for (std::size_t i = 0; i < vectorCount; i++) {
+      Vector vector;
+      for (std::size_t j = 0; j <= i % VectorInlineCapacity; j++) {
+        vector.push_back(static_cast<int>(j));
+      }
+      for (const auto element : vector) {
+        sum += static_cast<U64>(element);
+      }
+    }
+  };
+  const auto timing = measureRepeatedly(Repetitions, [&sum]() { sum = 0; }, buildVectors);
+  U64 expectedSum = 0;
+  for (std::size_t i = 0; i < vectorCount; i++) {
+    const auto elementCount = i % VectorInlineCapacity + 1;
+    expectedSum += elementCount * (elementCount - 1) / 2;
+  }
+  if (sum != expectedSum) {
+    throw std::logic_error(name + " temporaries did not hold the elements pushed into them.");
+  }
+  AllocationTrackerGuard allocationTrackerGuard(false, false);
+  buildVectors();
+  const auto allocations = allocationTrackerGuard.getAllocationsMade();
+  printThroughputAndAllocations(name + " temporaries", static_cast<double>(vectorCount) / timing.median / 1e6,
+                                static_cast<double>(allocations) / static_cast<double>(vectorCount));
+}
+
+void testSmallContainerThroughput() {
+  static constexpr int HeaderWidth = 46;
+  static constexpr int ColumnWidth = 14;
+  // Map lookups with random keys miss the cache, so fewer of them are needed for stable timings.
+  static constexpr std::size_t KeyCount = 200'000;
+  static constexpr std::size_t VectorCount = 1'000'000;
+  const auto keyCount = std::min(KeyCount, getExperimentOptions().maximumElementCount);
+  const auto vectorCount = std::min(VectorCount, getExperimentOptions().maximumElementCount);
+  std::cout << "Testing small containers against standard containers, in millions of operations per second and allocations per operation.\n";
+  std::cout << Indentation << Indentation << std::setw(HeaderWidth) << "" << std::setw(ColumnWidth) << "Million/s" << std::setw(ColumnWidth)
+            << "Allocations" << "\n";
+  std::cout << Indentation << toStringWithThousandsSeparators(keyCount) << " unordered_map keys of 16 to 40 random letters:\n";
+  const auto keyStrings = makeRandomKeys(keyCount);
+  testMapKeyThroughput<std::string>("std::string", keyStrings);
+  testMapKeyThroughput<SmallString<KeyInlineCapacity>>("SmallString<" + std::to_string(KeyInlineCapacity) + ">", keyStrings);
+  std::cout << Indentation << toStringWithThousandsSeparators(vectorCount) << " temporary vectors of 1 to 16 int elements:\n";
+  testTemporaryVectorThroughput<std::vector<int>>("std::vector<int>", vectorCount);
+  testTemporaryVectorThroughput<SmallVector<int, VectorInlineCapacity>>("SmallVector<int, " + std::to_string(VectorInlineCapacity) + ">",
+                                                                        vectorCount);
+}
 } // namespace Experiments
@@ -6,4 +6,14 @@ void testStringSize();
 void testStringMaximumSize();
 
 void testSmallStringOptimizationSize();
+
+/**
+ * Finds the sizes up to which std::string, std::vector, SmallString and SmallVector store their elements without allocating.
+ * */
+void testSmallContainerInlineStorage();
+
+/**
+ * Compares SmallString with std::string as unordered_map keys and SmallVector with std::vector as temporaries.
+ * */
+void testSmallContainerThroughput();
 } // namespace Experiments
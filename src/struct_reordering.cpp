@@ -1,7 +1,27 @@
 #include "struct_reordering.hpp"
 
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <iomanip>
+#include <initializer_list>
 #include <iostream>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
 
+#include <boost/type_index.hpp>
+
+#include "experiment_runner.hpp"
+#include "formatting.hpp"
+#include "layout_analyzer.hpp"
+#include "results.hpp"
+#include "soa_vector.hpp"
+#include "timing.hpp"
 #include "types.hpp"
 
 namespace Experiments {
@@ -29,4 +49,319 @@ void testStructReordering() noexcept {
   }
   std::cout << "reorder structs.\n";
 }
-} // namespace Experiments
\ No newline at end of file
+
+namespace {
+/**
+ * The fields of a record in the order in which they might be declared, with padding after each single byte.
+ * */
+struct PaddedRecord {
+  U8 flags;
+  U64 key;
+  U8 category;
+  double price;
+  U8 status;
+  U32 quantity;
+};
+
+/**
+ * The same fields ordered by decreasing alignment, which leaves only the padding at the end.
+ * */
+struct PackedRecord {
+  U64 key;
+  double price;
+  U32 quantity;
+  U8 flags;
+  U8 category;
+  U8 status;
+};
+
+// Reordering the fields of the hot record must not make it gain padding again.
+static_assert(isOptimallyOrdered<PackedRecord>());
+static_assert(!isOptimallyOrdered<PaddedRecord>());
+
+using RecordColumns = SoAVector<U64, double, U32, U8, U8, U8>;
+
+static constexpr std::size_t KeyColumn = 0;
+static constexpr std::size_t PriceColumn = 1;
+static constexpr std::size_t QuantityColumn = 2;
+static constexpr std::size_t FlagsColumn = 3;
+static constexpr std::size_t CategoryColumn = 4;
+static constexpr std::size_t StatusColumn = 5;
+
+/**
+ * The price is derived from the key, so that sorting can be checked to have moved every field along with its key.
+ * */
+[[nodiscard]] double getPriceOfKey(const U64 key) noexcept { return static_cast<double>(key % 100'000) / 100.0; }
+
+/**
+ * Calls the function with the fields of each record, which are the same for every layout.
+ * */
+template <typename Function> void generateRecords(const std::size_t count, Function function) {
+  std::mt19937_64 generator(count);
+  for (std::size_t i = 0; i < count; i++) {
+    const auto key = generator();
+    function(key, getPriceOfKey(key), static_cast<U32>(key >> 32u), static_cast<U8>(key), static_cast<U8>(key >> 8u), static_cast<U8>(key >> 16u));
+  }
+}
+
+/**
+ * A layout holds records and runs the workloads on them. The bytes touched are those of the cache lines a workload reads or writes in one pass over the
+ * records, as the cache loads whole lines and the records of the arrays of structs are smaller than a line.
+ * */
+template <typename Record> class ArrayOfStructs {
+  std::vector<Record> records;
+
+public:
+  static constexpr std::size_t RecordSize = sizeof(Record);
+  static constexpr std::size_t ScanBytesPerRecord = sizeof(Record);
+  static constexpr std::size_t UpdateBytesPerRecord = sizeof(Record);
+
+  void generate(const std::size_t count) {
+    records.clear();
+    records.reserve(count);
+    generateRecords(count, [this](const U64 key, const double price, const U32 quantity, const U8 flags, const U8 category, const U8 status) {
+      Record record{};
+      record.key = key;
+      record.price = price;
+      record.quantity = quantity;
+      record.flags = flags;
+      record.category = category;
+      record.status = status;
+      records.push_back(record);
+    });
+  }
+
+  [[nodiscard]] double sumPrices() const {
+    double sum = 0.0;
+    for (const auto &record : records) {
+      sum += record.price;
+    }
+    return sum;
+  }
+
+  void update() {
+    for (auto &record : records) {
+      record.price *= 1.01;
+      record.quantity++;
+      record.flags ^= 1u;
+      record.category++;
+      record.status = static_cast<U8>(record.flags & record.category);
+    }
+  }
+
+  void sortByKey() {
+    std::sort(std::begin(records), std::end(records), [](const Record &lhs, const Record &rhs) { return lhs.key < rhs.key; });
+  }
+
+  [[nodiscard]] bool isSortedByKey() const {
+    for (std::size_t i = 0; i < records.size(); i++) {
+      if ((i > 0 && records[i - 1].key > records[i].key) || records[i].price != getPriceOfKey(records[i].key)) {
+        return false;
+      }
+    }
+    return true;
+  }
+};
+
+class StructOfArrays {
+  RecordColumns columns;
+
+public:
+  static constexpr std::size_t RecordSize = RecordColumns::RecordSize;
+  static constexpr std::size_t ScanBytesPerRecord = sizeof(double);
+  /**
+   * Updates change every field but the key, whose column is not touched.
+   * */
+  static constexpr std::size_t UpdateBytesPerRecord = RecordColumns::RecordSize - sizeof(U64);
+
+  void generate(const std::size_t count) {
+    columns.clear();
+    columns.reserve(count);
+    generateRecords(count, [this](const U64 key, const double price, const U32 quantity, const U8 flags, const U8 category, const U8 status) {
+      columns.push_back(key, price, quantity, flags, category, status);
+    });
+  }
+
+  [[nodiscard]] double sumPrices() const {
+    double sum = 0.0;
+    for (const auto price : columns.column<PriceColumn>()) {
+      sum += price;
+    }
+    return sum;
+  }
+
+  void update() {
+    const auto prices = columns.column<PriceColumn>();
+    const auto quantities = columns.column<QuantityColumn>();
+    const auto flags = columns.column<FlagsColumn>();
+    const auto categories = columns.column<CategoryColumn>();
+    const auto statuses = columns.column<StatusColumn>();
+    for (std::size_t i = 0; i < columns.size(); i++) {
+      prices[i] *= 1.01;
+      quantities[i]++;
+      flags[i] ^= 1u;
+      categories[i]++;
+      statuses[i] = static_cast<U8>(flags[i] & categories[i]);
+    }
+  }
+
+  void sortByKey() { columns.sortBy<KeyColumn>(); }
+
+  [[nodiscard]] bool isSortedByKey() const {
+    const auto keys = columns.column<KeyColumn>();
+    const auto prices = columns.column<PriceColumn>();
+    for (std::size_t i = 0; i < keys.size(); i++) {
+      if ((i > 0 && keys[i - 1] > keys[i]) || prices[i] != getPriceOfKey(keys[i])) {
+        return false;
+      }
+    }
+    return true;
+  }
+};
+
+struct LayoutResult {
+  TimingStatistics scan;
+  TimingStatistics update;
+  TimingStatistics sort;
+  double priceSum;
+};
+} // namespace
+
+static constexpr std::size_t LayoutRepetitions = 3;
+
+template <typename Layout> static LayoutResult measureLayout(const std::size_t count) {
+  LayoutResult result{};
+  Layout layout;
+  layout.generate(count);
+  result.priceSum = layout.sumPrices();
+  result.scan = measureRepeatedly(
+      LayoutRepetitions, []() {},
+      [&layout]() {
+        auto sum = layout.sumPrices();
+        preventOptimization(sum);
+      });
+  result.update = measureRepeatedly(LayoutRepetitions, []() {}, [&layout]() { layout.update(); });
+  result.sort = measureRepeatedly(LayoutRepetitions, [&layout, count]() { layout.generate(count); }, [&layout]() { layout.sortByKey(); });
+  if (!layout.isSortedByKey()) {
+    throw std::logic_error("Sorting the records did not keep their fields together.");
+  }
+  return result;
+}
+
+static constexpr int LayoutNameWidth = 16;
+static constexpr int LayoutColumnWidth = 14;
+
+/**
+ * Throws std::logic_error if the layout does not hold the same records as the layouts measured before it.
+ * */
+template <typename Layout> static void printLayout(const std::string_view name, const std::size_t count, std::optional<double> &expectedPriceSum) {
+  const auto result = measureLayout<Layout>(count);
+  if (expectedPriceSum && *expectedPriceSum != result.priceSum) {
+    throw std::logic_error("The layouts do not hold the same records.");
+  }
+  expectedPriceSum = result.priceSum;
+  std::cout << Indentation << Indentation << std::setw(LayoutNameWidth) << std::left << name << std::right << std::setw(LayoutColumnWidth) << Layout::RecordSize
+            << std::setw(LayoutColumnWidth) << toDurationString(result.scan.median) << std::setw(LayoutColumnWidth)
+            << toStringWithThousandsSeparators(count * Layout::ScanBytesPerRecord) << std::setw(LayoutColumnWidth) << toDurationString(result.update.median)
+            << std::setw(LayoutColumnWidth) << toStringWithThousandsSeparators(count * Layout::UpdateBytesPerRecord) << std::setw(LayoutColumnWidth)
+            << toDurationString(result.sort.median) << "\n";
+  const auto metric = std::string(name) + " of " + std::to_string(count) + " records";
+  recordResult(metric + ", scan", result.scan.median, "s");
+  recordResult(metric + ", update", result.update.median, "s");
+  recordResult(metric + ", sort", result.sort.median, "s");
+}
+
+void testRecordLayouts() {
+  static constexpr std::array<std::size_t, 3> Counts{1'000'000, 10'000'000, 100'000'000};
+  const auto maximumCount = getExperimentOptions().maximumElementCount;
+  std::cout << "Testing scans of a hot field, updates of whole records and sorting by key with different record layouts.\n";
+  std::cout << Indentation << "Bytes touched are those of the cache lines read or written by one pass over the records.\n";
+  std::cout << Indentation << "They are not shown for sorting, which makes a different number of passes over different data with each layout.\n";
+  for (const auto count : Counts) {
+    if (count > maximumCount && count != Counts.front()) {
+      break;
+    }
+    const auto recordCount = std::min(count, maximumCount);
+    std::cout << Indentation << toStringWithThousandsSeparators(recordCount) << " records:\n";
+    std::cout << Indentation << Indentation << std::setw(LayoutNameWidth) << "";
+    for (const auto *const columnName : {"Record bytes", "Scan", "Scan bytes", "Update", "Update bytes", "Sort"}) {
+      std::cout << std::setw(LayoutColumnWidth) << columnName;
+    }
+    std::cout << "\n";
+    std::optional<double> expectedPriceSum;
+    printLayout<ArrayOfStructs<PaddedRecord>>("AoS, padded", recordCount, expectedPriceSum);
+    printLayout<ArrayOfStructs<PackedRecord>>("AoS, packed", recordCount, expectedPriceSum);
+    printLayout<StructOfArrays>("SoA", recordCount, expectedPriceSum);
+  }
+}
+
+namespace {
+struct Message {
+  bool urgent;
+  double timestamp;
+  bool acknowledged;
+  U32 sender;
+  U16 kind;
+};
+
+struct Envelope {
+  U8 version;
+  PackedRecord record;
+  U8 checksum;
+};
+
+struct Vertex {
+  float x;
+  float y;
+  float z;
+  U32 color;
+};
+} // namespace
+
+template <typename... Fields> static std::vector<std::string> getFieldTypeNames(TypeList<Fields...>) {
+  return {boost::typeindex::type_id<Fields>().pretty_name()...};
+}
+
+template <typename T> static void printLayoutReport(const std::string_view name) {
+  static constexpr int FieldColumnWidth = 10;
+  static constexpr int TypeColumnWidth = 56;
+  static constexpr int NumberColumnWidth = 16;
+  constexpr auto report = analyzeLayout<T>();
+  const auto typeNames = getFieldTypeNames(FieldTypes<T>{});
+  std::cout << Indentation << name << " has " << pluralizeAsNeeded(report.fields.size(), "field") << ", " << pluralizeAsNeeded(report.size, "byte")
+            << " including " << pluralizeAsNeeded(report.paddingBytes, "byte") << " of padding, and would have "
+            << pluralizeAsNeeded(report.optimalSize, "byte") << " with its fields ordered by decreasing alignment.\n";
+  if (!report.matchesCompiler) {
+    std::cout << Indentation << "The compiler laid it out differently, in " << pluralizeAsNeeded(sizeof(T), "byte") << ".\n";
+  }
+  std::cout << Indentation << Indentation << std::setw(FieldColumnWidth) << std::left << "Field" << std::setw(TypeColumnWidth) << "Type" << std::right;
+  for (const auto *const columnName : {"Offset", "Size", "Alignment", "Padding before"}) {
+    std::cout << std::setw(NumberColumnWidth) << columnName;
+  }
+  std::cout << "\n";
+  for (std::size_t i = 0; i < report.fields.size(); i++) {
+    const auto &field = report.fields[i];
+    std::cout << Indentation << Indentation << std::setw(FieldColumnWidth) << std::left << i << std::setw(TypeColumnWidth) << typeNames[i] << std::right;
+    for (const auto value : {field.offset, field.size, field.alignment, field.paddingBefore}) {
+      std::cout << std::setw(NumberColumnWidth) << value;
+    }
+    std::cout << "\n";
+  }
+  if (report.trailingPadding != 0) {
+    std::cout << Indentation << Indentation << "Padding after the last field: " << pluralizeAsNeeded(report.trailingPadding, "byte") << ".\n";
+  }
+  recordResult(std::string(name) + " size", static_cast<double>(report.size), "bytes", MetricDirection::Exact);
+  recordResult(std::string(name) + " padding", static_cast<double>(report.paddingBytes), "bytes", MetricDirection::Exact);
+  recordResult(std::string(name) + " size ordered by alignment", static_cast<double>(report.optimalSize), "bytes", MetricDirection::Exact);
+}
+
+void testStructLayouts() {
+  std::cout << "Testing the layouts of some aggregates, as computed at compile time from their fields.\n";
+  printLayoutReport<A>("A");
+  printLayoutReport<PaddedRecord>("PaddedRecord");
+  printLayoutReport<PackedRecord>("PackedRecord");
+  printLayoutReport<Message>("Message");
+  printLayoutReport<Envelope>("Envelope");
+  printLayoutReport<Vertex>("Vertex");
+}
+} // namespace Experiments
@@ -10,4 +10,16 @@ namespace Experiments {
  * This test aims to verify whether or not the compiler is performing struct reordering.
  * */
 void testStructReordering() noexcept;
+
+/**
+ * Compares arrays of padded and of packed structs with a structure of arrays, scanning one field, updating every field and sorting by key from 1 million
+ * up to 100 million records, within the maximum element count.
+ * */
+void testRecordLayouts();
+
+/**
+ * Prints the offset of each field, the padding and the size with the best ordering of the fields of some sample aggregates, which analyzeLayout computes at
+ * compile time.
+ * */
+void testStructLayouts();
 } // namespace Experiments
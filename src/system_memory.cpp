@@ -0,0 +1,133 @@
+#include "system_memory.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <system_error>
+#include <utility>
+
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include "formatting.hpp"
+
+namespace Experiments {
+std::vector<ReportedCacheSize> getReportedCacheSizes() {
+  static constexpr std::array<std::pair<std::string_view, int>, 3> CacheLevels{{
+      {"L1 data", _SC_LEVEL1_DCACHE_SIZE},
+      {"L2", _SC_LEVEL2_CACHE_SIZE},
+      {"L3", _SC_LEVEL3_CACHE_SIZE},
+  }};
+  std::vector<ReportedCacheSize> cacheSizes;
+  for (const auto &[level, name] : CacheLevels) {
+    const auto size = sysconf(name);
+    if (size > 0) {
+      cacheSizes.push_back({level, static_cast<std::size_t>(size)});
+    }
+  }
+  return cacheSizes;
+}
+
+void printReportedCacheSizes() {
+  std::vector<std::string> cacheSizes;
+  for (const auto &[level, size] : getReportedCacheSizes()) {
+    cacheSizes.push_back(std::string(level) + " of " + toByteSizeString(size));
+  }
+  if (cacheSizes.empty()) {
+    std::cout << Indentation << "The system does not report the sizes of its caches.\n";
+  } else {
+    std::cout << Indentation << "The system reports caches of " << enumerate(cacheSizes) << ".\n";
+  }
+}
+
+std::string getTransparentHugePageMode() {
+  // The file lists every mode and brackets the selected one, such as "always [madvise] never".
+  std::ifstream stream("/sys/kernel/mm/transparent_hugepage/enabled");
+  std::string modes;
+  std::getline(stream, modes);
+  const auto begin = modes.find('[');
+  const auto end = modes.find(']', begin);
+  if (begin == std::string::npos || end == std::string::npos) {
+    return {};
+  }
+  return modes.substr(begin + 1, end - begin - 1);
+}
+
+[[nodiscard]] static std::size_t roundUp(const std::size_t value, const std::size_t multiple) { return (value + multiple - 1) / multiple * multiple; }
+
+MappedMemory::MappedMemory(const std::size_t size, const HugePageAdvice advice, const PagePopulation population) : size(size) {
+  const auto pageSize = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+  // Mapping a huge page more than needed leaves room to align the start, and the unused ends are unmapped, even if MAP_POPULATE populated them.
+  const auto mappingSize = roundUp(size, pageSize) + HugePageSize;
+  const auto flags = MAP_PRIVATE | MAP_ANONYMOUS | (population == PagePopulation::MapPopulate ? MAP_POPULATE : 0);
+  void *const mapping = mmap(nullptr, mappingSize, PROT_READ | PROT_WRITE, flags, -1, 0);
+  if (mapping == MAP_FAILED) {
+    throw std::system_error(errno, std::generic_category(), "Could not map " + toByteSizeString(size));
+  }
+  const auto mappingStart = reinterpret_cast<std::uintptr_t>(mapping);
+  const auto alignedStart = roundUp(mappingStart, HugePageSize);
+  const auto alignedEnd = alignedStart + roundUp(size, pageSize);
+  if (alignedStart != mappingStart) {
+    munmap(mapping, alignedStart - mappingStart);
+  }
+  if (alignedEnd != mappingStart + mappingSize) {
+    munmap(reinterpret_cast<void *>(alignedEnd), mappingStart + mappingSize - alignedEnd);
+  }
+  start = reinterpret_cast<U8 *>(alignedStart);
+  if (advice != HugePageAdvice::None && madvise(start, size, advice == HugePageAdvice::Enabled ? MADV_HUGEPAGE : MADV_NOHUGEPAGE) != 0) {
+    const auto error = errno;
+    munmap(start, size);
+    throw std::system_error(error, std::generic_category(), "Could not advise the kernel on huge pages for " + toByteSizeString(size));
+  }
+  if (population == PagePopulation::PopulateWrite) {
+#ifdef MADV_POPULATE_WRITE
+    const auto error = madvise(start, size, MADV_POPULATE_WRITE) == 0 ? 0 : errno;
+#else
+    const auto error = ENOTSUP;
+#endif
+    if (error != 0) {
+      munmap(start, size);
+      throw std::system_error(error, std::generic_category(), "Could not populate " + toByteSizeString(size));
+    }
+  }
+}
+
+std::size_t getHugePageBackedSize(const void *const address, const std::size_t size) {
+  // Each mapping starts with a line such as "7f0000000000-7f0000200000 rw-p 00000000 00:00 0", followed by lines such as "AnonHugePages: 2048 kB".
+  std::ifstream stream("/proc/self/smaps");
+  const auto begin = reinterpret_cast<std::uintptr_t>(address);
+  const auto end = begin + size;
+  bool overlaps = false;
+  std::size_t hugePageBackedSize = 0;
+  std::string line;
+  while (std::getline(stream, line)) {
+    const auto dash = line.find('-');
+    const auto space = line.find(' ');
+    if (dash != std::string::npos && space != std::string::npos && dash < space && line.find(':') > space) {
+      const auto mappingBegin = std::stoull(line.substr(0, dash), nullptr, 16);
+      const auto mappingEnd = std::stoull(line.substr(dash + 1, space - dash - 1), nullptr, 16);
+      overlaps = mappingBegin < end && begin < mappingEnd;
+    } else if (overlaps && line.starts_with("AnonHugePages:")) {
+      std::istringstream fields(line.substr(line.find(':') + 1));
+      std::size_t kibibytes = 0;
+      fields >> kibibytes;
+      hugePageBackedSize += kibibytes * 1024;
+    }
+  }
+  // A mapping which the kernel merged with its neighbors may have huge pages outside of this memory.
+  return std::min(hugePageBackedSize, size);
+}
+
+U64 getMinorPageFaults() noexcept {
+  rusage usage{};
+  getrusage(RUSAGE_SELF, &usage);
+  return static_cast<U64>(usage.ru_minflt);
+}
+
+MappedMemory::~MappedMemory() { munmap(start, size); }
+} // namespace Experiments
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "types.hpp"
+
+namespace Experiments {
+/**
+ * The size of a transparent huge page on x86-64, which is also the alignment huge pages need.
+ * */
+static constexpr std::size_t HugePageSize = 2 * 1024 * 1024;
+
+struct ReportedCacheSize {
+  std::string_view level;
+  std::size_t size;
+};
+
+/**
+ * Returns the sizes of the data caches which the C library reports, from the innermost level, leaving out those it does not report.
+ *
+ * Virtual machines often report the caches of the whole host, or nothing.
+ * */
+[[nodiscard]] std::vector<ReportedCacheSize> getReportedCacheSizes();
+
+void printReportedCacheSizes();
+
+/**
+ * Returns the system-wide transparent huge page mode, which is always, madvise or never, or an empty string if the kernel does not have them.
+ * */
+[[nodiscard]] std::string getTransparentHugePageMode();
+
+enum class HugePageAdvice {
+  /**
+   * Leaves the choice to the system-wide transparent huge page mode.
+   * */
+  None,
+  Disabled,
+  Enabled
+};
+
+enum class PagePopulation {
+  /**
+   * Each page is faulted in by the first access to it.
+   * */
+  OnFirstTouch,
+  /**
+   * mmap() populates the pages with MAP_POPULATE, before any huge page advice applies.
+   * */
+  MapPopulate,
+  /**
+   * madvise(MADV_POPULATE_WRITE), which Linux has since 5.14, populates the pages after the huge page advice, so they can be huge pages.
+   * */
+  PopulateWrite
+};
+
+/**
+ * Returns how many bytes of the memory huge pages back, according to /proc/self/smaps, or zero if that cannot be read.
+ * */
+[[nodiscard]] std::size_t getHugePageBackedSize(const void *address, std::size_t size);
+
+/**
+ * Returns the minor page faults of this process so far, which are those served without reading from a disk, such as the first touch of anonymous memory.
+ * */
+[[nodiscard]] U64 getMinorPageFaults() noexcept;
+
+/**
+ * Anonymous private memory mapped with mmap, whose start is aligned to HugePageSize so that huge pages can back all of it.
+ *
+ * Unless the memory is populated, the first access to each page faults.
+ * */
+class MappedMemory {
+  U8 *start = nullptr;
+  std::size_t size = 0;
+
+public:
+  /**
+   * Throws std::system_error if the memory cannot be mapped, advised or populated.
+   * */
+  MappedMemory(std::size_t size, HugePageAdvice advice, PagePopulation population = PagePopulation::OnFirstTouch);
+
+  MappedMemory(const MappedMemory &) = delete;
+
+  MappedMemory &operator=(const MappedMemory &) = delete;
+
+  [[nodiscard]] U8 *data() const noexcept { return start; }
+
+  [[nodiscard]] std::size_t getSize() const noexcept { return size; }
+
+  [[nodiscard]] std::size_t getHugePageBackedSize() const { return Experiments::getHugePageBackedSize(start, size); }
+
+  ~MappedMemory();
+};
+} // namespace Experiments
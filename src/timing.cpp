@@ -0,0 +1,146 @@
+#include "timing.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <iostream>
+#include <iterator>
+#include <mutex>
+#include <numeric>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+
+#include "formatting.hpp"
+
+namespace Experiments {
+static std::atomic<bool> recordingMeasuredRegions = false;
+static std::atomic<U64> endedMeasuredRegionCount = 0;
+static PerformanceCounters *measuredRegionPerformanceCounters = nullptr;
+static std::mutex measuredRegionSamplesMutex;
+static std::vector<MeasuredRegionSamples> measuredRegionSamples;
+
+TimingStatistics computeTimingStatistics(std::vector<double> samples) {
+  TimingStatistics statistics;
+  statistics.sampleCount = samples.size();
+  if (samples.empty()) {
+    return statistics;
+  }
+  std::sort(std::begin(samples), std::end(samples));
+  statistics.minimum = samples.front();
+  const auto middle = samples.size() / 2;
+  statistics.median = samples.size() % 2 == 1 ? samples[middle] : (samples[middle - 1] + samples[middle]) / 2.0;
+  statistics.mean = std::accumulate(std::begin(samples), std::end(samples), 0.0) / static_cast<double>(samples.size());
+  if (samples.size() > 1) {
+    double squaredDeviations = 0.0;
+    for (const auto sample : samples) {
+      squaredDeviations += (sample - statistics.mean) * (sample - statistics.mean);
+    }
+    statistics.standardDeviation = std::sqrt(squaredDeviations / static_cast<double>(samples.size() - 1));
+  }
+  return statistics;
+}
+
+std::vector<std::size_t> getScalingThreadCounts() {
+  const auto hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+  std::vector<std::size_t> threadCounts;
+  for (std::size_t threadCount = 1; threadCount < hardwareThreads; threadCount *= 2) {
+    threadCounts.push_back(threadCount);
+  }
+  threadCounts.push_back(hardwareThreads);
+  return threadCounts;
+}
+
+static void addPerformanceCounterReadings(std::vector<PerformanceCounterReading> &totals, const std::vector<PerformanceCounterReading> &readings) {
+  if (totals.empty()) {
+    totals = readings;
+    return;
+  }
+  for (std::size_t i = 0; i < totals.size() && i < readings.size(); i++) {
+    if (totals[i].value && readings[i].value) {
+      *totals[i].value += *readings[i].value;
+    } else {
+      totals[i].value.reset();
+    }
+  }
+}
+
+MeasuredRegion::MeasuredRegion(const std::string_view name, const U64 itemCount) : regionName(name), regionItemCount(itemCount) {
+  if (recordingMeasuredRegions && measuredRegionPerformanceCounters != nullptr) {
+    measuredRegionPerformanceCounters->start();
+  }
+  start = std::chrono::steady_clock::now();
+}
+
+MeasuredRegion::~MeasuredRegion() {
+  const auto end = std::chrono::steady_clock::now();
+  endedMeasuredRegionCount.fetch_add(1, std::memory_order_relaxed);
+  if (!recordingMeasuredRegions) {
+    return;
+  }
+  std::vector<PerformanceCounterReading> performanceCounterReadings;
+  if (measuredRegionPerformanceCounters != nullptr) {
+    measuredRegionPerformanceCounters->stop();
+    performanceCounterReadings = measuredRegionPerformanceCounters->read();
+  }
+  const auto duration = std::chrono::duration<double>(end - start).count();
+  std::lock_guard lock(measuredRegionSamplesMutex);
+  const auto matchesName = [this](const MeasuredRegionSamples &samples) { return samples.name == regionName; };
+  auto samples = std::find_if(std::begin(measuredRegionSamples), std::end(measuredRegionSamples), matchesName);
+  if (samples == std::end(measuredRegionSamples)) {
+    measuredRegionSamples.push_back({std::string(regionName), regionItemCount, {}, {}});
+    samples = std::prev(std::end(measuredRegionSamples));
+  }
+  samples->durations.push_back(duration);
+  addPerformanceCounterReadings(samples->performanceCounterTotals, performanceCounterReadings);
+}
+
+MeasuredRegionRecorder::MeasuredRegionRecorder(const bool countingPerformanceEvents)
+    : performanceCounters(countingPerformanceEvents ? std::make_unique<PerformanceCounters>() : nullptr) {
+  if (recordingMeasuredRegions) {
+    throw std::runtime_error("Tried to record measured regions with a second recorder, this is not allowed.");
+  }
+  std::lock_guard lock(measuredRegionSamplesMutex);
+  measuredRegionSamples.clear();
+  measuredRegionPerformanceCounters = performanceCounters.get();
+  recordingMeasuredRegions = true;
+}
+
+std::vector<MeasuredRegionSamples> MeasuredRegionRecorder::takeSamples() {
+  std::lock_guard lock(measuredRegionSamplesMutex);
+  return std::exchange(measuredRegionSamples, {});
+}
+
+MeasuredRegionRecorder::~MeasuredRegionRecorder() {
+  recordingMeasuredRegions = false;
+  std::lock_guard lock(measuredRegionSamplesMutex);
+  measuredRegionPerformanceCounters = nullptr;
+  measuredRegionSamples.clear();
+}
+
+U64 getEndedMeasuredRegionCount() noexcept { return endedMeasuredRegionCount.load(std::memory_order_relaxed); }
+
+void printTimingStatistics(const MeasuredRegionSamples &samples) {
+  const auto statistics = computeTimingStatistics(samples.durations);
+  std::cout << Indentation << samples.name << " (" << pluralizeAsNeeded(statistics.sampleCount, "sample") << ")\n";
+  std::cout << Indentation << Indentation << "min " << toDurationString(statistics.minimum);
+  std::cout << ", median " << toDurationString(statistics.median);
+  std::cout << ", mean " << toDurationString(statistics.mean);
+  std::cout << ", standard deviation " << toDurationString(statistics.standardDeviation) << "\n";
+  if (samples.itemCount > 1 && statistics.median > 0.0) {
+    const auto itemsPerSecond = static_cast<double>(samples.itemCount) / statistics.median;
+    std::cout << Indentation << Indentation << toStringWithThousandsSeparators(static_cast<U64>(itemsPerSecond));
+    std::cout << " items per second at the median, " << toDurationString(statistics.median / static_cast<double>(samples.itemCount)) << " per item\n";
+  }
+  if (!samples.performanceCounterTotals.empty() && statistics.sampleCount != 0) {
+    auto averages = samples.performanceCounterTotals;
+    for (auto &average : averages) {
+      if (average.value) {
+        *average.value /= statistics.sampleCount;
+      }
+    }
+    std::cout << Indentation << Indentation << "Performance counters per sample:\n";
+    printPerformanceCounterReadings(averages, 3);
+  }
+}
+} // namespace Experiments
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <latch>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "performance_counters.hpp"
+#include "types.hpp"
+
+namespace Experiments {
+struct TimingStatistics {
+  std::size_t sampleCount = 0;
+  /**
+   * All durations are in seconds.
+   * */
+  double minimum = 0.0;
+  double median = 0.0;
+  double mean = 0.0;
+  double standardDeviation = 0.0;
+};
+
+[[nodiscard]] TimingStatistics computeTimingStatistics(std::vector<double> samples);
+
+/**
+ * Times the body the given number of times, calling the setup before each repetition without timing it.
+ * */
+template <typename Setup, typename Body> [[nodiscard]] TimingStatistics measureRepeatedly(const std::size_t repetitions, Setup &&setup, Body &&body) {
+  std::vector<double> samples;
+  samples.reserve(repetitions);
+  for (std::size_t i = 0; i < repetitions; i++) {
+    setup();
+    const auto start = std::chrono::steady_clock::now();
+    body();
+    const auto end = std::chrono::steady_clock::now();
+    samples.push_back(std::chrono::duration<double>(end - start).count());
+  }
+  return computeTimingStatistics(std::move(samples));
+}
+
+/**
+ * Keeps the compiler from optimizing away the computation of the value or the writes to it.
+ * */
+template <typename T> void preventOptimization(T &value) noexcept { asm volatile("" : : "r"(&value) : "memory"); }
+
+/**
+ * Returns 1, 2, 4 and so on up to the number of hardware threads, which is always included.
+ * */
+[[nodiscard]] std::vector<std::size_t> getScalingThreadCounts();
+
+/**
+ * Runs the function on the given number of threads at once, passing each its index, and returns the seconds from releasing the threads, once they have all
+ * started, until the last one finishes.
+ * */
+template <typename Function> [[nodiscard]] double measureConcurrently(const std::size_t threadCount, Function function) {
+  std::latch started(static_cast<std::ptrdiff_t>(threadCount) + 1);
+  std::latch released(1);
+  std::chrono::steady_clock::time_point start;
+  {
+    std::vector<std::jthread> threads;
+    threads.reserve(threadCount);
+    for (std::size_t i = 0; i < threadCount; i++) {
+      threads.emplace_back([i, &function, &started, &released]() {
+        started.count_down();
+        released.wait();
+        function(i);
+      });
+    }
+    started.arrive_and_wait();
+    start = std::chrono::steady_clock::now();
+    released.count_down();
+  }
+  return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * Marks the region of an experiment which is timed when benchmarking, so that setup outside of it is excluded.
+ *
+ * When no MeasuredRegionRecorder is alive, this does nothing but read the clock twice, so it does not allocate and can be used inside an
+ * AllocationTrackerGuard.
+ * */
+class MeasuredRegion {
+  std::string_view regionName;
+  U64 regionItemCount;
+  std::chrono::steady_clock::time_point start;
+
+public:
+  /**
+   * Regions with the same name are considered repetitions of each other. The item count is used to compute throughput.
+   *
+   * The name must outlive the region.
+   * */
+  explicit MeasuredRegion(std::string_view name, U64 itemCount = 1);
+
+  MeasuredRegion(const MeasuredRegion &) = delete;
+
+  MeasuredRegion &operator=(const MeasuredRegion &) = delete;
+
+  ~MeasuredRegion();
+};
+
+struct MeasuredRegionSamples {
+  std::string name;
+  U64 itemCount;
+  std::vector<double> durations;
+  /**
+   * The sums of the performance counters over all samples, if they were counted.
+   * */
+  std::vector<PerformanceCounterReading> performanceCounterTotals;
+};
+
+/**
+ * Collects the durations of all measured regions which end while it is alive, from any thread. Only one recorder may be alive at a time.
+ *
+ * If it counts performance events, each region starts and stops the counters, so the regions being recorded must neither nest nor run concurrently.
+ * */
+class MeasuredRegionRecorder {
+  std::unique_ptr<PerformanceCounters> performanceCounters;
+
+public:
+  explicit MeasuredRegionRecorder(bool countingPerformanceEvents = false);
+
+  MeasuredRegionRecorder(const MeasuredRegionRecorder &) = delete;
+
+  MeasuredRegionRecorder &operator=(const MeasuredRegionRecorder &) = delete;
+
+  /**
+   * Returns the samples collected so far, in the order in which the regions first ended, and clears them.
+   * */
+  [[nodiscard]] std::vector<MeasuredRegionSamples> takeSamples();
+
+  ~MeasuredRegionRecorder();
+};
+
+/**
+ * Returns how many measured regions have ended so far, whether they were recorded or not.
+ * */
+[[nodiscard]] U64 getEndedMeasuredRegionCount() noexcept;
+
+void printTimingStatistics(const MeasuredRegionSamples &samples);
+} // namespace Experiments
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+
+#include "memory.hpp"
+
+namespace Experiments {
+/**
+ * An allocator which counts what a single container allocates into the statistics it is given, unlike AllocationTrackerGuard, which counts every
+ * allocation of the process.
+ *
+ * Copies and rebound copies count into the same statistics, so the node allocations of a container are counted along with its other allocations. Like the
+ * containers using it, it must not be used from several threads at once.
+ * */
+template <typename T> class TrackingAllocator {
+  template <typename U> friend class TrackingAllocator;
+
+  AllocationStatistics *statistics;
+
+public:
+  using value_type = T;
+
+  explicit TrackingAllocator(AllocationStatistics &allocationStatistics) noexcept : statistics(&allocationStatistics) {}
+
+  template <typename U> explicit(false) TrackingAllocator(const TrackingAllocator<U> &rhs) noexcept : statistics(rhs.statistics) {}
+
+  [[nodiscard]] T *allocate(const std::size_t count) {
+    auto *const pointer = std::allocator<T>().allocate(count);
+    const auto size = count * sizeof(T);
+    statistics->allocations++;
+    statistics->allocatedBytes += size;
+    statistics->sizeClassAllocations[getAllocationSizeClass(size)]++;
+    statistics->peakLiveBytes = std::max(statistics->peakLiveBytes, static_cast<std::size_t>(statistics->getLiveBytes()));
+    return pointer;
+  }
+
+  void deallocate(T *const pointer, const std::size_t count) noexcept {
+    std::allocator<T>().deallocate(pointer, count);
+    statistics->deallocations++;
+    statistics->freedBytes += count * sizeof(T);
+  }
+
+  [[nodiscard]] const AllocationStatistics &getStatistics() const noexcept { return *statistics; }
+
+  template <typename U> [[nodiscard]] bool operator==(const TrackingAllocator<U> &rhs) const noexcept { return statistics == rhs.statistics; }
+};
+} // namespace Experiments
@@ -0,0 +1,246 @@
+#include "unordered_map_operations.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <version>
+
+#include "experiment_runner.hpp"
+#include "formatting.hpp"
+#include "memory.hpp"
+#include "results.hpp"
+#include "timing.hpp"
+#include "types.hpp"
+
+namespace Experiments {
+static constexpr std::size_t MaximumKeyCount = 100'000;
+static constexpr std::size_t OperationRepetitions = 3;
+/**
+ * Short keys fit in the small string optimization of every major standard library, long keys fit in none, as is usual for request paths.
+ * */
+static constexpr std::array<std::size_t, 2> KeyLengths{8, 40};
+static constexpr U32 RateDecimalPlaces = 2;
+
+using StringMap = std::unordered_map<std::string, U64>;
+static constexpr std::string_view StringMapName = "std::unordered_map<std::string, U64>";
+
+/**
+ * Distinct keys of exactly the given length, in a shuffled order.
+ * */
+static std::vector<std::string> makeKeys(const std::size_t count, const std::size_t length) {
+  std::vector<std::string> keys;
+  keys.reserve(count);
+  for (std::size_t i = 0; i < count; i++) {
+    const auto digits = std::to_string(i);
+    if (digits.size() > length) {
+      throw std::logic_error("Keys of " + std::to_string(length) + " characters cannot tell " + std::to_string(count) + " keys apart.");
+    }
+    keys.push_back(std::string(length - digits.size(), 'k') + digits);
+  }
+  std::shuffle(std::begin(keys), std::end(keys), std::mt19937(0));
+  return keys;
+}
+
+namespace {
+struct InsertOperation {
+  std::string_view name;
+  /**
+   * Inserts every key with its index as its value, whether the key is in the map or not.
+   * */
+  void (*insertAll)(StringMap &map, const std::vector<std::string> &keys);
+};
+
+struct OperationMeasurement {
+  double millionsOfOperationsPerSecond = 0.0;
+  double allocationsPerOperation = 0.0;
+};
+} // namespace
+
+static constexpr std::array<InsertOperation, 5> InsertOperations{{
+    {"insert",
+     [](StringMap &map, const std::vector<std::string> &keys) {
+       for (std::size_t i = 0; i < keys.size(); i++) {
+         // The pair, and the copy of the key in it, is built before insert() can tell whether the key is in the map.
+         map.insert(StringMap::value_type(keys[i], i));
+       }
+     }},
+    {"emplace",
+     [](StringMap &map, const std::vector<std::string> &keys) {
+       for (std::size_t i = 0; i < keys.size(); i++) {
+         map.emplace(keys[i], i);
+       }
+     }},
+    {"try_emplace",
+     [](StringMap &map, const std::vector<std::string> &keys) {
+       for (std::size_t i = 0; i < keys.size(); i++) {
+         map.try_emplace(keys[i], i);
+       }
+     }},
+    {"insert_or_assign",
+     [](StringMap &map, const std::vector<std::string> &keys) {
+       for (std::size_t i = 0; i < keys.size(); i++) {
+         map.insert_or_assign(keys[i], i);
+       }
+     }},
+    {"operator[]",
+     [](StringMap &map, const std::vector<std::string> &keys) {
+       for (std::size_t i = 0; i < keys.size(); i++) {
+         map[keys[i]] = i;
+       }
+     }},
+}};
+
+/**
+ * Times inserting every key after the setup, and then counts the allocations of one more run after the setup.
+ * */
+template <typename Setup>
+static OperationMeasurement measureInsertOperation(const InsertOperation &operation, StringMap &map, const std::vector<std::string> &keys, Setup &&setup) {
+  const auto timingStatistics = measureRepeatedly(OperationRepetitions, setup, [&operation, &map, &keys]() { operation.insertAll(map, keys); });
+  setup();
+  AllocationTrackerGuard allocationTrackerGuard(false, false, false, false);
+  operation.insertAll(map, keys);
+  const auto allocations = allocationTrackerGuard.getAllocationsMade();
+  if (map.size() != keys.size()) {
+    throw std::logic_error(std::string(operation.name) + " left " + std::to_string(map.size()) + " keys in the map instead of " +
+                           std::to_string(keys.size()) + ".");
+  }
+  const auto operations = static_cast<double>(keys.size());
+  return {operations / timingStatistics.median / 1e6, static_cast<double>(allocations) / operations};
+}
+
+void testUnorderedMapInsertion() {
+  static constexpr int OperationWidth = 20;
+  static constexpr int ColumnWidth = 16;
+  const auto keyCount = std::min(MaximumKeyCount, getExperimentOptions().maximumElementCount);
+  for (const auto keyLength : KeyLengths) {
+    const auto keys = makeKeys(keyCount, keyLength);
+    std::cout << "Testing inserting " << toStringWithThousandsSeparators(keyCount) << " keys of " << keyLength << " characters into "
+              << StringMapName << ".\n";
+    std::cout << Indentation << "New keys are inserted into an empty map which reserved room for them, conflicting keys into a map which has them.\n";
+    std::cout << Indentation << std::setw(OperationWidth) << "" << std::setw(2 * ColumnWidth) << "New keys" << std::setw(2 * ColumnWidth)
+              << "Conflicting keys" << "\n";
+    std::cout << Indentation << std::setw(OperationWidth) << "";
+    for (std::size_t i = 0; i < 2; i++) {
+      std::cout << std::setw(ColumnWidth) << "M operations/s" << std::setw(ColumnWidth) << "Allocations/op";
+    }
+    std::cout << "\n";
+    OperationMeasurement conflictingEmplace;
+    for (const auto &operation : InsertOperations) {
+      StringMap map;
+      const auto newKeys = measureInsertOperation(operation, map, keys, [&map, &keys]() {
+        map = StringMap();
+        map.reserve(keys.size());
+      });
+      const auto conflictingKeys = measureInsertOperation(operation, map, keys, []() {});
+      if (operation.name == "emplace") {
+        conflictingEmplace = conflictingKeys;
+      }
+      std::cout << Indentation << std::setw(OperationWidth) << std::left << operation.name << std::right;
+      for (const auto &measurement : {newKeys, conflictingKeys}) {
+        std::cout << std::setw(ColumnWidth) << toFixedPrecisionString(measurement.millionsOfOperationsPerSecond, RateDecimalPlaces) << std::setw(ColumnWidth)
+                  << toFixedPrecisionString(measurement.allocationsPerOperation, RateDecimalPlaces);
+      }
+      std::cout << "\n";
+      const auto metric = std::string(operation.name) + " of " + std::to_string(keyLength) + "-character keys";
+      recordResult(metric + ", new", newKeys.millionsOfOperationsPerSecond, "M operations/s", MetricDirection::HigherIsBetter);
+      recordResult(metric + ", new, allocations", newKeys.allocationsPerOperation, "allocations/operation");
+      recordResult(metric + ", conflicting", conflictingKeys.millionsOfOperationsPerSecond, "M operations/s", MetricDirection::HigherIsBetter);
+      recordResult(metric + ", conflicting, allocations", conflictingKeys.allocationsPerOperation, "allocations/operation");
+    }
+    if (conflictingEmplace.allocationsPerOperation > 0.0) {
+      std::cout << Indentation << "emplace() built a node before finding that its key was in the map, and then freed it.\n";
+    }
+  }
+}
+
+namespace {
+/**
+ * Hashes anything which converts to a std::string_view, so that a map with this hash and std::equal_to<> finds std::string keys from a std::string_view.
+ * */
+struct TransparentStringHash {
+  using is_transparent = void;
+
+  [[nodiscard]] std::size_t operator()(const std::string_view key) const noexcept { return std::hash<std::string_view>{}(key); }
+};
+} // namespace
+
+using TransparentStringMap = std::unordered_map<std::string, U64, TransparentStringHash, std::equal_to<>>;
+
+/**
+ * Looks up every view, which refers to a key in the map, and reports the throughput and the allocations per lookup.
+ * */
+template <typename Map, typename Find>
+static void testLookup(const std::string_view name, const std::vector<std::string> &keys, const std::vector<std::string_view> &views, const Find &find) {
+  static constexpr int NameWidth = 24;
+  static constexpr int ColumnWidth = 20;
+  Map map;
+  for (std::size_t i = 0; i < keys.size(); i++) {
+    map.emplace(keys[i], i);
+  }
+  U64 sum = 0;
+  const auto findAll = [&map, &views, &find, &sum]() {
+    for (const auto view : views) {
+      const auto iterator = find(map, view);
+      if (iterator == std::end(map)) {
+        throw std::logic_error("A key which is in the map was not found.");
+      }
+      sum += iterator->second;
+    }
+  };
+  const auto timingStatistics = measureRepeatedly(OperationRepetitions, []() {}, findAll);
+  AllocationTrackerGuard allocationTrackerGuard(false, false, false, false);
+  findAll();
+  const auto allocations = allocationTrackerGuard.getAllocationsMade();
+  preventOptimization(sum);
+  const auto lookups = static_cast<double>(views.size());
+  const auto millionsOfLookupsPerSecond = lookups / timingStatistics.median / 1e6;
+  const auto allocationsPerLookup = static_cast<double>(allocations) / lookups;
+  std::cout << Indentation << std::setw(NameWidth) << std::left << name << std::right << std::setw(ColumnWidth)
+            << toFixedPrecisionString(millionsOfLookupsPerSecond, RateDecimalPlaces) << std::setw(ColumnWidth)
+            << toFixedPrecisionString(allocationsPerLookup, RateDecimalPlaces) << "\n";
+  const auto metric = std::string(name) + " of " + std::to_string(keys.front().size()) + "-character keys";
+  recordResult(metric, millionsOfLookupsPerSecond, "M lookups/s", MetricDirection::HigherIsBetter);
+  recordResult(metric + ", allocations", allocationsPerLookup, "allocations/lookup");
+}
+
+void testHeterogeneousLookup() {
+  static constexpr int NameWidth = 24;
+  static constexpr int ColumnWidth = 20;
+  const auto keyCount = std::min(MaximumKeyCount, getExperimentOptions().maximumElementCount);
+  for (const auto keyLength : KeyLengths) {
+    const auto keys = makeKeys(keyCount, keyLength);
+    // The looked up keys are views into one buffer, as keys parsed out of a request would be.
+    std::string buffer;
+    buffer.reserve(keyCount * keyLength);
+    for (const auto &key : keys) {
+      buffer += key;
+    }
+    std::vector<std::string_view> views;
+    views.reserve(keyCount);
+    for (std::size_t i = 0; i < keyCount; i++) {
+      views.push_back(std::string_view(buffer).substr(i * keyLength, keyLength));
+    }
+    std::shuffle(std::begin(views), std::end(views), std::mt19937(1));
+    std::cout << "Testing looking up " << toStringWithThousandsSeparators(keyCount) << " std::string_view keys of " << keyLength
+              << " characters in a map with std::string keys.\n";
+    std::cout << Indentation << std::setw(NameWidth) << "" << std::setw(ColumnWidth) << "M lookups/s" << std::setw(ColumnWidth) << "Allocations/lookup"
+              << "\n";
+    testLookup<StringMap>("Temporary std::string", keys, views, [](const StringMap &map, const std::string_view key) { return map.find(std::string(key)); });
+#ifdef __cpp_lib_generic_unordered_lookup
+    testLookup<TransparentStringMap>("Transparent hash", keys, views,
+                                     [](const TransparentStringMap &map, const std::string_view key) { return map.find(key); });
+#else
+    std::cout << Indentation << "This standard library cannot look up keys of another type in unordered containers.\n";
+#endif
+  }
+}
+} // namespace Experiments
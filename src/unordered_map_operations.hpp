@@ -0,0 +1,15 @@
+#pragma once
+
+namespace Experiments {
+/**
+ * Compares the throughput and the allocations per operation of insert(), emplace(), try_emplace(), insert_or_assign() and operator[] on a
+ * std::unordered_map with std::string keys, both for keys which are new and for keys which are already in the map.
+ * */
+void testUnorderedMapInsertion();
+
+/**
+ * Compares looking up std::string_view keys in a std::unordered_map with std::string keys through a temporary std::string and through a transparent hash,
+ * which C++20 allows to look up the std::string_view directly, for keys which fit in the small string optimization and for keys which do not.
+ * */
+void testHeterogeneousLookup();
+} // namespace Experiments